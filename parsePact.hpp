@@ -24,16 +24,31 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
+#include <bit>
 #include <cctype>
+#include <coroutine>
+#include <cstdint>
 #include <cstdio>
 #include <cstdlib>
 #include <iostream>
 #include <limits>
+#include <mutex>
 #include <numeric>
 #include <optional>
+#include <span>
 #include <string_view>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
+#if defined(__x86_64__) or defined(__i386__)
+# define _PARSEPACT_X86
+# include <immintrin.h>
+#endif
+
 namespace pp::internal
 {
   /////////////////////////////////////////////////////////////////
@@ -128,14 +143,42 @@ namespace pp::internal
     }
   };
   
-  /// Custom bitset
+  /// Determines whether the cpu running the program supports the AVX2 instructions
+  ///
+  /// The check is carried out once at runtime, so that the AVX2
+  /// kernels are used also when the program is not compiled for AVX2
+  inline bool cpuSupportsAvx2()
+  {
+#if defined(_PARSEPACT_X86)
+    /// Result of the check
+    static const bool supported=
+      []()
+      {
+	__builtin_cpu_init();
+	
+	return __builtin_cpu_supports("avx2");
+      }();
+    
+    return supported;
+#else
+    return false;
+#endif
+  }
+  
+  /// Custom bitset, stored in 64-bit words
   struct BitSet
   {
+    /// Type of the word holding the bits
+    using Word=uint64_t;
+    
+    /// Number of bits in a word
+    static constexpr size_t wordBits=std::numeric_limits<Word>::digits;
+    
     /// Number of bits
     size_t n;
     
     /// Stored data
-    std::vector<char> data;
+    std::vector<Word> data;
     
     /// Returns the size
     constexpr size_t size() const
@@ -144,9 +187,9 @@ namespace pp::internal
     }
     
     /// Construct allowing n bits
-    constexpr BitSet(const size_t& n) :
+    constexpr BitSet(const size_t& n=0) :
       n(n),
-      data((n+7)/8,0)
+      data((n+wordBits-1)/wordBits,0)
     {
     }
     
@@ -154,45 +197,31 @@ namespace pp::internal
     constexpr void setTo(const size_t& iEl,
 			 const bool& b) &
     {
-      /// Index of the byte
-      const size_t iByte=iEl/8;
-      
-      /// Index of the bit
-      const char iBit=iEl%8;
-      
       /// Target data
-      char& f=data[iByte];
-      
-      /// Mask needed to erase the bit
-      const char mask=~(char(1)<<iBit);
+      Word& f=data[iEl/wordBits];
       
-      /// Bit value to be added
-      const char add=char(b)<<iBit;
+      /// Mask of the bit
+      const Word mask=Word(1)<<(iEl%wordBits);
       
-      f=(f&mask)|add;
+      f=(f&~mask)|(-Word(b)&mask);
     }
     
     /// Set an element
     constexpr void set(const size_t& iEl) &
     {
-      setTo(iEl,true);
+      data[iEl/wordBits]|=Word(1)<<(iEl%wordBits);
     }
     
     /// Unset an element
     constexpr void unSet(const size_t& iEl) &
     {
-      setTo(iEl,false);
+      data[iEl/wordBits]&=~(Word(1)<<(iEl%wordBits));
     }
     
     /// Access a given bit
     constexpr bool get(const size_t& iEl) const
     {
-      const size_t i=iEl/8;
-      const char j=iEl%8;
-      const char& f=data[i];
-      const char mask=char(1)<<j;
-      
-      return f&mask;
+      return (data[iEl/wordBits]>>(iEl%wordBits))&1;
     }
     
     /// Subscribe a bit
@@ -201,21 +230,221 @@ namespace pp::internal
       return get(iEl);
     }
     
-    constexpr size_t insert(const BitSet& oth)
+    /// Counts the set bits
+    constexpr size_t count() const
     {
+      /// Returned count
       size_t r=0;
       
-      for(size_t i=0;i<data.size();i++)
+      for(const Word& w : data)
+	r+=std::popcount(w);
+      
+      return r;
+    }
+    
+    /// Returns whether no bit is set
+    constexpr bool none() const
+    {
+      for(const Word& w : data)
+	if(w)
+	  return false;
+      
+      return true;
+    }
+    
+    /// Returns the first set bit not preceding iEl, or the size if none is found
+    constexpr size_t findNext(const size_t& iEl) const
+    {
+      /// Index of the word being searched
+      size_t iWord=iEl/wordBits;
+      
+      if(iWord>=data.size())
+	return n;
+      
+      /// Bits of the first word, not preceding iEl
+      Word w=data[iWord]&(~Word(0)<<(iEl%wordBits));
+      
+      while(w==0)
+	if(++iWord<data.size())
+	  w=data[iWord];
+	else
+	  return n;
+      
+      return iWord*wordBits+std::countr_zero(w);
+    }
+    
+    /// Returns the first set bit, or the size if none is found
+    constexpr size_t findFirst() const
+    {
+      return findNext(0);
+    }
+    
+    /// Calls the function f on each set bit, in increasing order
+    template <typename F>
+    constexpr void forEach(F&& f) const
+    {
+      for(size_t iWord=0;iWord<data.size();iWord++)
+	for(Word w=data[iWord];w;w&=w-1)
+	  f(iWord*wordBits+std::countr_zero(w));
+    }
+    
+#if defined(_PARSEPACT_X86)
+    /// Inserts the words of the other set in groups of four, returning the number of processed words
+    __attribute__((target("avx2")))
+    static size_t insertAvx2(Word* data,
+			     const Word* oth,
+			     const size_t& nWords,
+			     size_t& nNewBits)
+    {
+      /// Index of the group
+      size_t i=0;
+      
+      for(;i+4<=nWords;i+=4)
+	{
+	  /// Pointer to the words of this set
+	  __m256i* d=(__m256i*)&data[i];
+	  
+	  /// Loaded words of this set
+	  const __m256i a=_mm256_loadu_si256(d);
+	  
+	  /// Loaded words of the other set
+	  const __m256i b=_mm256_loadu_si256((const __m256i*)&oth[i]);
+	  
+	  /// Bits which are set in the other set but not in this one
+	  alignas(32) Word newBits[4];
+	  _mm256_store_si256((__m256i*)newBits,_mm256_andnot_si256(a,b));
+	  for(const Word& w : newBits)
+	    nNewBits+=std::popcount(w);
+	  
+	  _mm256_storeu_si256(d,_mm256_or_si256(a,b));
+	}
+      
+      return i;
+    }
+    
+    /// Intersects with the words of the other set in groups of four, returning the number of processed words
+    __attribute__((target("avx2")))
+    static size_t intersectAvx2(Word* data,
+				const Word* oth,
+				const size_t& nWords)
+    {
+      /// Index of the group
+      size_t i=0;
+      
+      for(;i+4<=nWords;i+=4)
+	{
+	  /// Pointer to the words of this set
+	  __m256i* d=(__m256i*)&data[i];
+	  
+	  _mm256_storeu_si256(d,_mm256_and_si256(_mm256_loadu_si256(d),_mm256_loadu_si256((const __m256i*)&oth[i])));
+	}
+      
+      return i;
+    }
+    
+    /// Removes the words of the other set in groups of four, returning the number of processed words
+    __attribute__((target("avx2")))
+    static size_t removeAvx2(Word* data,
+			     const Word* oth,
+			     const size_t& nWords)
+    {
+      /// Index of the group
+      size_t i=0;
+      
+      for(;i+4<=nWords;i+=4)
 	{
-	  char c=data[i]^oth.data[i];
-	  for(int i=0;i<8;i++)
-	    r+=(c>>i)&1;
+	  /// Pointer to the words of this set
+	  __m256i* d=(__m256i*)&data[i];
 	  
+	  _mm256_storeu_si256(d,_mm256_andnot_si256(_mm256_loadu_si256((const __m256i*)&oth[i]),_mm256_loadu_si256(d)));
+	}
+      
+      return i;
+    }
+#endif
+    
+    /// Inserts the set bits of the other set, returning the number of newly set bits
+    constexpr size_t insert(const BitSet& oth)
+    {
+      /// Number of newly set bits
+      size_t r=0;
+      
+      /// Index of the first word to be processed by the scalar loop
+      size_t i=0;
+      
+#if defined(_PARSEPACT_X86)
+      if(not std::is_constant_evaluated() and cpuSupportsAvx2())
+	i=insertAvx2(data.data(),oth.data.data(),data.size(),r);
+#endif
+      
+      for(;i<data.size();i++)
+	{
+	  r+=std::popcount(Word(oth.data[i]&~data[i]));
 	  data[i]|=oth.data[i];
 	}
       
       return r;
     }
+    
+    /// Inserts the set bits of the other set, with atomic word-level
+    /// unions when not evaluated at compile time, so that several threads
+    /// can insert into the same set
+    constexpr void insertConcurrently(const BitSet& oth)
+    {
+      if(std::is_constant_evaluated())
+	insert(oth);
+      else
+	for(size_t i=0;i<data.size();i++)
+	  if(oth.data[i])
+	    std::atomic_ref<Word>(data[i]).fetch_or(oth.data[i],std::memory_order_relaxed);
+    }
+    
+    /// Keeps only the bits set also in the other set
+    constexpr BitSet& intersect(const BitSet& oth)
+    {
+      /// Index of the first word to be processed by the scalar loop
+      size_t i=0;
+      
+#if defined(_PARSEPACT_X86)
+      if(not std::is_constant_evaluated() and cpuSupportsAvx2())
+	i=intersectAvx2(data.data(),oth.data.data(),data.size());
+#endif
+      
+      for(;i<data.size();i++)
+	data[i]&=oth.data[i];
+      
+      return *this;
+    }
+    
+    /// Removes the bits set in the other set
+    constexpr BitSet& remove(const BitSet& oth)
+    {
+      /// Index of the first word to be processed by the scalar loop
+      size_t i=0;
+      
+#if defined(_PARSEPACT_X86)
+      if(not std::is_constant_evaluated() and cpuSupportsAvx2())
+	i=removeAvx2(data.data(),oth.data.data(),data.size());
+#endif
+      
+      for(;i<data.size();i++)
+	data[i]&=~oth.data[i];
+      
+      return *this;
+    }
+    
+    /// Returns whether the two sets share some bit
+    constexpr bool intersects(const BitSet& oth) const
+    {
+      for(size_t i=0;i<data.size();i++)
+	if(data[i]&oth.data[i])
+	  return true;
+      
+      return false;
+    }
+    
+    /// Comparison
+    constexpr bool operator==(const BitSet& oth) const = default;
   };
   
   /// Parameters to hold a vector of vectors of heterogeneous size, on the stack
@@ -347,6 +576,215 @@ namespace pp::internal
       return {false,std::distance(v.begin(),it)};
   }
   
+  /////////////////////////////////////////////////////////////////
+  ////////////////////////// Hashing //////////////////////////////
+  /////////////////////////////////////////////////////////////////
+  
+  /// Combines the hash seed with a further value
+  constexpr size_t hashCombine(const size_t& seed,
+			       const size_t& v)
+  {
+    return seed^(v+0x9e3779b9+(seed<<6)+(seed>>2));
+  }
+  
+  /// Hash table holding the position of the elements of a vector,
+  /// allowing to check in constant time if an element is present
+  ///
+  /// The elements must provide a hash() method, and must be added to
+  /// the vector only through maybeAdd
+  struct HashedUniqueVectorIndex
+  {
+    /// Marks an empty bucket
+    static constexpr size_t emptyBucket=
+      std::numeric_limits<size_t>::max();
+    
+    /// Position of the element in the vector, for each bucket
+    std::vector<size_t> buckets;
+    
+    /// Returns the bucket where the element is, or where it should be placed
+    template <typename T>
+    constexpr size_t findBucket(const std::vector<T>& v,
+				const T& x) const
+    {
+      /// Mask to get the bucket from the hash
+      const size_t mask=
+	buckets.size()-1;
+      
+      /// Bucket, linearly probed starting from the hash
+      size_t iBucket=
+	x.hash()&mask;
+      
+      while(buckets[iBucket]!=emptyBucket and not (v[buckets[iBucket]]==x))
+	iBucket=(iBucket+1)&mask;
+      
+      return iBucket;
+    }
+    
+    /// Searches the element, returning its position if found
+    template <typename T>
+    constexpr std::optional<size_t> find(const std::vector<T>& v,
+					 const T& x) const
+    {
+      if(buckets.empty())
+	return {};
+      
+      if(const size_t& iPos=buckets[findBucket(v,x)];iPos!=emptyBucket)
+	return iPos;
+      else
+	return {};
+    }
+    
+    /// Possibly adds an element, returning whether it has been added and its position
+    template <typename T>
+    constexpr std::pair<bool,size_t> maybeAdd(std::vector<T>& v,
+					      const T& x)
+    {
+      // Keep the load below one half, reindexing the whole vector
+      if(2*(v.size()+1)>buckets.size())
+	{
+	  buckets.assign(std::max<size_t>(16,2*buckets.size()),emptyBucket);
+	  for(size_t iPos=0;iPos<v.size();iPos++)
+	    buckets[findBucket(v,v[iPos])]=iPos;
+	}
+      
+      if(size_t& iPos=buckets[findBucket(v,x)];iPos==emptyBucket)
+	{
+	  iPos=v.size();
+	  v.push_back(x);
+	  
+	  return {true,iPos};
+	}
+      else
+	return {false,iPos};
+    }
+  };
+  
+  /////////////////////////////////////////////////////////////////
+  ///////////////////////// Relations /////////////////////////////
+  /////////////////////////////////////////////////////////////////
+  
+  /// Computes F(x)=F'(x) | F(y) for all y such that x R y, for all x
+  ///
+  /// Implements the digraph algorithm of DeRemer and Pennello, in
+  /// which all the x of a strongly connected component of R get the
+  /// same set, such that each set is joined only once per relation
+  /// pair. The sets are passed initialized to F', the relation is
+  /// passed as the list of y for each x. The recursion is unrolled
+  /// on an explicit stack, to be insensitive to the depth of R
+  constexpr void digraph(std::vector<BitSet>& f,
+			 const std::vector<std::vector<size_t>>& relation)
+  {
+    /// Marks that the component of x has been completed
+    constexpr size_t completed=
+      std::numeric_limits<size_t>::max();
+    
+    /// Depth of each x in the stack, 0 if not yet visited
+    std::vector<size_t> depth(f.size(),0);
+    
+    /// Stack of the x being traversed
+    std::vector<size_t> stack;
+    
+    /// Call stack: x, number of processed y, depth at which x was entered
+    std::vector<std::tuple<size_t,size_t,size_t>> callStack;
+    
+    /// Enters the traversal of x
+    const auto enter=
+      [&depth,
+       &stack,
+       &callStack](const size_t& x)
+      {
+	stack.push_back(x);
+	depth[x]=stack.size();
+	callStack.emplace_back(x,0,stack.size());
+      };
+    
+    for(size_t xStart=0;xStart<f.size();xStart++)
+      if(depth[xStart]==0)
+	{
+	  enter(xStart);
+	  
+	  while(not callStack.empty())
+	    if(auto& [x,iY,d]=callStack.back();iY<relation[x].size())
+	      {
+		if(const size_t y=relation[x][iY];depth[y]==0)
+		  enter(y);
+		else
+		  {
+		    depth[x]=std::min(depth[x],depth[y]);
+		    f[x].insert(f[y]);
+		    iY++;
+		  }
+	      }
+	    else
+	      {
+		if(depth[x]==d)
+		  {
+		    /// Element of the component, popped from the stack
+		    size_t z;
+		    
+		    do
+		      {
+			z=stack.back();
+			stack.pop_back();
+			
+			depth[z]=completed;
+			if(z!=x)
+			  f[z]=f[x];
+		      }
+		    while(z!=x);
+		  }
+		
+		callStack.pop_back();
+	      }
+	}
+  }
+  
+  /////////////////////////////////////////////////////////////////
+  ////////////////////////// Threading ////////////////////////////
+  /////////////////////////////////////////////////////////////////
+  
+  /// Calls f on all indices up to n, dynamically distributed over nThreads threads
+  ///
+  /// The calling thread takes part in the work, and the others are
+  /// joined before returning
+  template <typename F>
+  inline void parallelFor(const size_t& nThreads,
+			  const size_t& n,
+			  const F& f)
+  {
+    /// Next index to be processed
+    std::atomic<size_t> iNext{0};
+    
+    /// Work carried out by each thread
+    const auto work=
+      [&iNext,
+       &n,
+       &f]()
+      {
+	for(size_t i;(i=iNext++)<n;)
+	  f(i);
+      };
+    
+    /// Threads helping the calling one
+    std::vector<std::jthread> threads;
+    for(size_t iThread=1;iThread<std::min(nThreads,n);iThread++)
+      threads.emplace_back(work);
+    
+    work();
+  }
+  
+  /// Runs f on a separate thread while g runs on the calling one
+  template <typename F,
+	    typename G>
+  inline void runConcurrently(const F& f,
+			      const G& g)
+  {
+    /// Thread running f
+    const std::jthread thread(f);
+    
+    g();
+  }
+  
   /////////////////////////////////////////////////////////////////
   ///////////////////////// Diagnostic ////////////////////////////
   /////////////////////////////////////////////////////////////////
@@ -359,12 +797,27 @@ namespace pp::internal
     exit(1);
   }
   
+  /// Serializes the diagnostic output of different threads
+  inline std::mutex diagnosticMutex;
+  
+  /// Print to terminal the whole message at once, so that the
+  /// messages of grammars or regex matchers built concurrently are not
+  /// interleaved
+  template <typename...Args>
+  inline void printDiagnostic(const Args&...args)
+  {
+    /// Lock of the output
+    const std::lock_guard lock(diagnosticMutex);
+    
+    ((std::cout<<args),...);
+  }
+  
   /// Print to terminal if not evaluated at compile time
   template <typename...Args>
   constexpr void diagnostic(Args&&...args)
   {
     if(not std::is_constant_evaluated())
-      ((std::cout<<args),...);
+      printDiagnostic(args...);
   }
   
   /////////////////////////////////////////////////////////////////
@@ -806,16 +1259,16 @@ namespace pp::internal
     enum State : bool {UNACCEPTED,ACCEPTED};
     
     /// Store the number of temptative actions, to properly indent the diagnostic
-    inline size_t nNestedActions=0;
+    ///
+    /// Kept per thread, so that several matchers can be built concurrently
+    inline thread_local size_t nNestedActions=0;
     
     /// Print to terminal if not evaluated at compile time, adding proper indentation
     template <typename...Args>
     constexpr void diagnostic(Args&&...args)
     {
       if(not std::is_constant_evaluated())
-      	for(size_t i=0;i<temptative::nNestedActions;i++)
-	  std::cout<<"\t";
-      pp::internal::diagnostic(std::forward<Args>(args)...);
+	pp::internal::diagnostic(std::string(temptative::nNestedActions,'\t'),std::forward<Args>(args)...);
     }
     
     /// When destroyed, performs the action unless the action is accepted
@@ -1765,6 +2218,29 @@ namespace pp::internal
     /// Import the static polymorphism cast
     using StaticPolymorphic<T>::self;
     
+    /// DState reached from the dState through the char, if any
+    constexpr std::optional<size_t> nextDState(const size_t& dState,
+					       const char& c) const
+    {
+      auto trans=self().transitions.begin()+self().dStates[dState].transitionsBegin;
+      while(trans!=self().transitions.end() and trans->iDStateFrom==dState and not((trans->beg<=c and trans->end>c)))
+	trans++;
+      
+      if(trans!=self().transitions.end() and trans->iDStateFrom==dState)
+	return trans->nextDState;
+      else
+	return {};
+    }
+    
+    /// Token accepted by the dState, if any
+    constexpr std::optional<size_t> acceptedToken(const size_t& dState) const
+    {
+      if(self().dStates[dState].accepting)
+	return self().dStates[dState].iToken;
+      else
+	return {};
+    }
+    
     /// Match a string
     constexpr std::optional<RegexMatchingResult> match(std::string_view str) const
     {
@@ -1774,33 +2250,64 @@ namespace pp::internal
       /// Start dState
       size_t dState=0;
       
-      while(dState<self().dStates.size())
+      while(true)
 	{
-	  diagnostic("\nEntering dState ",dState,"\n");
 	  const char& c=
 	    str.empty()?'\0':str.front();
 	  
-	  diagnostic("trying to match char: \'",c,"\'\n");
-	  
-	  auto trans=self().transitions.begin()+self().dStates[dState].transitionsBegin;
-	  diagnostic("First transition: ",self().dStates[dState].transitionsBegin,"\n");
-	  while(trans!=self().transitions.end() and trans->iDStateFrom==dState and not((trans->beg<=c and trans->end>c)))
-	    {
-	      diagnostic("Ignored transition ",rangeDescribe(trans->beg,trans->end),"\n");
-	      trans++;
-	    }
-	  
-	  if(trans!=self().transitions.end() and trans->iDStateFrom==dState)
+	  if(const std::optional<size_t> next=nextDState(dState,c))
 	    {
-	      dState=trans->nextDState;
-	      diagnostic("matched ",c," with trans ",trans->iDStateFrom," ",rangeDescribe(trans->beg,trans->end),", going to dState ",dState,"\n");
+	      dState=*next;
 	      str.remove_prefix(1);
 	    }
 	  else
-	    if(self().dStates[dState].accepting)
-	      return RegexMatchingResult{std::string_view{oriStr,str.begin()},self().dStates[dState].iToken};
+	    if(const std::optional<size_t> iToken=acceptedToken(dState))
+	      return RegexMatchingResult{std::string_view{oriStr,str.begin()},*iToken};
+	    else
+	      return {};
+	}
+    }
+    
+    /// Matches the next token which is not the skipped one, removing it and the skipped ones from the string
+    ///
+    /// The skipped tokens are matched by the same loop, restarting the
+    /// DFA after each of them without returning. Returns nothing if
+    /// the string is over, or if no token can be matched, in which
+    /// case the string is left at the unmatched position. A matcher
+    /// without dStates matches no token
+    constexpr std::optional<RegexMatchingResult> matchSkipping(std::string_view& str,
+							       const size_t& iSkippedToken) const
+    {
+      while(not str.empty() and not self().dStates.empty())
+	{
+	  /// Current dState
+	  size_t dState=0;
+	  
+	  /// Length of the matched string
+	  size_t length=0;
+	  
+	  while(length<str.size())
+	    if(const std::optional<size_t> next=nextDState(dState,str[length]))
+	      {
+		dState=*next;
+		length++;
+	      }
 	    else
-	      dState=self().dStates.size();
+	      break;
+	  
+	  /// Token accepted in the reached dState
+	  const std::optional<size_t> iToken=acceptedToken(dState);
+	  
+	  if(not iToken or length==0)
+	    return {};
+	  
+	  /// Matched string
+	  const std::string_view matchedString=str.substr(0,length);
+	  
+	  str.remove_prefix(length);
+	  
+	  if(*iToken!=iSkippedToken)
+	    return RegexMatchingResult{matchedString,*iToken};
 	}
       
       return {};
@@ -2231,16 +2738,23 @@ namespace pp::internal
     /// Productions which reduce to this symbol
     std::vector<size_t> iProductions;
     
-    /// Productions reachable by the rightmost derivation, from this symbol, by the first production symbol
-    std::vector<size_t> iProductionsReachableByFirstSymbol;
+    /// Productions reachable by the rightmost derivation, from this
+    /// symbol, by the first production symbol, which form the closure
+    BitSet closureProductions;
     
     /// ermine if this symbol is nullable
     bool nullable;
     
     /// Determine the first elements of the subtree that must match something
-    std::vector<size_t> firsts;
+    BitSet firstIs;
     
     /// Determine the following elements
+    BitSet followIs;
+    
+    /// List of the first elements, for compatibility
+    std::vector<size_t> firsts;
+    
+    /// List of the following elements, for compatibility
     std::vector<size_t> follows;
     
     /// Construct the symbol
@@ -2258,6 +2772,40 @@ namespace pp::internal
     constexpr GrammarSymbol()=default;
   };
   
+  /// Lexer mode, recognizing its own set of terminals
+  ///
+  /// Matching some of the terminals switches the lexer to another mode
+  struct GrammarLexerMode
+  {
+    /// Name of the mode
+    std::string_view name;
+    
+    /// Determines whether the mode has been declared, rather than only entered
+    bool isDeclared;
+    
+    /// Terminals listed in the mode, paired with the mode entered after matching them
+    std::vector<std::pair<size_t,size_t>> iTerminalsAndNextModes;
+    
+    /// Regex matcher of the terminals, left empty for the initial mode which uses the one of the grammar
+    RegexMatcher regexMatcher;
+    
+    /// Determines whether the terminal is listed in the mode
+    constexpr bool lists(const size_t& iSymbol) const
+    {
+      return std::ranges::find(iTerminalsAndNextModes,iSymbol,&std::pair<size_t,size_t>::first)!=iTerminalsAndNextModes.end();
+    }
+    
+    /// Mode entered after matching the terminal, starting from the given mode
+    constexpr size_t iNextMode(const size_t& iSymbol,
+			       const size_t& iMode) const
+    {
+      /// Terminal and mode to be entered
+      const auto ref=std::ranges::find(iTerminalsAndNextModes,iSymbol,&std::pair<size_t,size_t>::first);
+      
+      return (ref==iTerminalsAndNextModes.end())?iMode:ref->second;
+    }
+  };
+  
   /// A production rule of a grammar
   struct GrammarProduction
   {
@@ -2350,95 +2898,106 @@ namespace pp::internal
       
       return out;
     }
+    
+    /// Hash of the item, combining production and position
+    constexpr size_t hash() const
+    {
+      return hashCombine(iProduction,position);
+    }
+    
     auto operator<=>(const GrammarItem&) const = default;
   };
   
-  /// State in the parser state machine
+  /// State in the parser state machine, represented by its kernel
   struct GrammarState
   {
-    /// Indices of the items describing the state
+    /// Indices of the kernel items describing the state, the closure is computed on demand
     std::vector<size_t> iItems;
     
-    /// Search the passed item
-    constexpr std::optional<size_t> findItem(const std::vector<GrammarItem>& items,
-					     const GrammarItem& item) const
+    /// Hash of the state, combining the indices of the items
+    constexpr size_t hash() const
     {
-      /// Poisition of the item, if found
-      size_t iSearchItem=0;
+      size_t res=iItems.size();
       
-      while(iSearchItem<iItems.size())
-	if(const size_t iItem=iItems[iSearchItem];items[iItem]==item)
-	  return iItem;
-	else
-	  iSearchItem++;
+      for(const size_t& iItem : iItems)
+	res=hashCombine(res,iItem);
       
-      return {};
+      return res;
     }
     
-    /// Creates a goto state
-    constexpr GrammarState createGotoState(const size_t& iSymbol,
-					   std::vector<GrammarItem>& items,
-					   const std::vector<GrammarProduction>& productions,
-					   const std::vector<GrammarSymbol>& symbols) const
+    /// Computes the productions forming the closure of the state, joining those of the symbols following the kernel items
+    constexpr BitSet closureProductions(const std::vector<GrammarItem>& items,
+					const std::vector<GrammarProduction>& productions,
+					const std::vector<GrammarSymbol>& symbols) const
     {
-      /// Returned gotostate
-      GrammarState gotoState;
+      /// Returned closure
+      BitSet res(productions.size());
       
       for(const size_t& iItem : iItems)
-	{
-	  const GrammarItem& item=items[iItem];
-	  if(item.position<productions[item.iProduction].iRhsList.size())
-	    {
-	      const size_t& iNextSymbol=productions[item.iProduction].iRhsList[item.position];
-	      
-	      auto add=
-		[&gotoState,
-		 &items](const size_t iProduction,
-			 const size_t position)
-		{
-		  const auto [res,iAdded]=maybeAddToUniqueVector(items,{iProduction,position});
-		  maybeAddToUniqueVector(gotoState.iItems,iAdded);
-		};
-	      
-	      if(iSymbol==iNextSymbol)
-		{
-		  // diagnostic(" Reached symbol ",symbols[iSymbol].name,"\n");
-		  add(item.iProduction,item.position+1);
-		}
-	      
-	      for(const size_t& iProduction : symbols[iNextSymbol].iProductionsReachableByFirstSymbol)
-		if(const GrammarProduction& production=productions[iProduction];production.iRhsList[0]==iSymbol)
-		  {
-		    // diagnostic(" Reached production ",describe(production)," whose first rhs is the symbol ",symbols[iSymbol].name,"\n");
-		    add(iProduction,1);
-		  }
-	    }
-	}
+	if(const GrammarItem& item=items[iItem];item.position<productions[item.iProduction].iRhsList.size())
+	  res.insert(symbols[productions[item.iProduction].iRhsList[item.position]].closureProductions);
+      
+      return res;
+    }
+    
+    /// Lists the items reached from the closed state, paired with the
+    /// symbol through which they are reached, in the order in which they
+    /// must be interned
+    ///
+    /// The items at the beginning of the closure productions are
+    /// listed as well without any symbol, to be later listed among the
+    /// closed items. The items are only read, so that the goto items of
+    /// several states can be listed concurrently
+    constexpr std::vector<std::pair<std::optional<size_t>,GrammarItem>> listGotoItems(const std::vector<GrammarItem>& items,
+											const std::vector<GrammarProduction>& productions,
+											const std::vector<GrammarSymbol>& symbols) const
+    {
+      /// Returned list
+      std::vector<std::pair<std::optional<size_t>,GrammarItem>> res;
+      
+      for(const size_t& iItem : iItems)
+	if(const GrammarItem item=items[iItem];item.position<productions[item.iProduction].iRhsList.size())
+	  res.emplace_back(productions[item.iProduction].iRhsList[item.position],GrammarItem{item.iProduction,item.position+1});
+      
+      closureProductions(items,productions,symbols).forEach([&productions,&res](const size_t& iProduction)
+      {
+	res.emplace_back(std::nullopt,GrammarItem{iProduction,0});
+	
+	if(const std::vector<size_t>& iRhsList=productions[iProduction].iRhsList;iRhsList.size())
+	  res.emplace_back(iRhsList.front(),GrammarItem{iProduction,1});
+      });
       
-      return gotoState;
+      return res;
     }
     
-    /// Adds the closure of the state
-    constexpr inline void addClosure(std::vector<GrammarItem>& items,
-				     const std::vector<GrammarProduction>& productions,
-				     const std::vector<GrammarSymbol>& symbols)
+    /// Creates the goto states out of the listed goto items, in order
+    /// of symbol, with the items sorted to make the comparison canonical
+    static constexpr std::vector<std::pair<size_t,GrammarState>> createGotoStates(const std::vector<std::pair<std::optional<size_t>,GrammarItem>>& listedGotoItems,
+										   std::vector<GrammarItem>& items,
+										   HashedUniqueVectorIndex& itemsIndex)
     {
-      for(size_t iIItem=0;iIItem<iItems.size();iIItem++)
+      /// Symbol and index of the item reached through it, for all items of the closed state
+      std::vector<std::pair<size_t,size_t>> gotoItems;
+      
+      for(const auto& [iSymbol,item] : listedGotoItems)
+	if(const size_t iGotoItem=itemsIndex.maybeAdd(items,item).second;iSymbol)
+	  gotoItems.emplace_back(*iSymbol,iGotoItem);
+      
+      std::sort(gotoItems.begin(),gotoItems.end());
+      gotoItems.erase(std::unique(gotoItems.begin(),gotoItems.end()),gotoItems.end());
+      
+      /// Returned goto states, paired with the symbol
+      std::vector<std::pair<size_t,GrammarState>> gotoStates;
+      
+      for(const auto& [iSymbol,iGotoItem] : gotoItems)
 	{
-	  /// As we might be modifying items
-	  auto item=
-	    [&]()
-	    {
-	      return items[iItems[iIItem]];
-	    };
+	  if(gotoStates.empty() or gotoStates.back().first!=iSymbol)
+	    gotoStates.emplace_back(iSymbol,GrammarState{});
 	  
-	  if(const std::vector<size_t>& iRhsList=productions[item().iProduction].iRhsList;item().position<iRhsList.size())
-	    for(const size_t& iProduction : symbols[iRhsList[item().position]].iProductions)
-	      {
-		if(const size_t iItem=maybeAddToUniqueVector(items,{iProduction,0}).second;maybeAddToUniqueVector(iItems,iItem).first)
-		  diagnostic("  Adding to the closure of \"",productions[item().iProduction].describe(symbols),"\" production: \"",productions[iProduction].describe(symbols),"\"\n");
-	      }
+	  gotoStates.back().second.iItems.push_back(iGotoItem);
 	}
+      
+      return gotoStates;
     }
     
     /// Returns a description of the state in a string
@@ -2506,1152 +3065,3968 @@ namespace pp::internal
     auto operator<=>(const GrammarTransition& oth) const = default;
   };
   
-  /// Lookeahead
-  struct Lookahead
+  /// Transition of the LR(0) automaton over a non-terminal symbol, on which the lookaheads are computed
+  struct GrammarNonTerminalTransition
   {
-    /// Symbols of the lookahead
-    BitSet symbolIs;
+    /// State from which the transition starts
+    size_t iState;
     
-    /// List of lookaheads to which the lookahead propagates to
-    std::vector<size_t> iPropagateToItems;
+    /// Non-terminal symbol mediating the transition
+    size_t iSymbol;
     
-    ///Constructor
-    constexpr Lookahead(const size_t& n) :
-      symbolIs(n)
-    {
-    }
+    /// State reached by the transition
+    size_t iGotoState;
   };
   
-  /// Specifications of the grammar
-  struct GrammarSpecs
+  /// Reduction to be performed in a state, with the lookahead on which to perform it
+  struct GrammarReduction
   {
-    /// Number of symbols
-    const size_t nSymbols;
+    /// Production to be reduced
+    size_t iProduction;
     
-    const Stack2DVectorPars productionPars;
+    /// Symbols of the lookahead
+    BitSet symbolIs;
+  };
+  
+  /// Action of the parser for a given state and lookahead symbol, packed in a single word
+  struct GrammarAction
+  {
+    /// Type used to store the packed action
+    using Word=uint32_t;
     
-    const size_t nItems;
+    /// Type of the action
+    enum Type : Word {ERROR,SHIFT,REDUCE};
     
-    const Stack2DVectorPars stateItemsPars;
+    /// Number of bits used to store the type
+    static constexpr size_t nTypeBits=2;
     
-    const Stack2DVectorPars stateTransitionsPars;
+    /// Number of states or productions which can be packed with the type
+    static constexpr size_t nTargets=
+      Word(1)<<(8*sizeof(Word)-nTypeBits);
     
-    const RegexMatcherSizes regexMachinePars;
+    /// Packed type and target state (if shift) or production (if reduce)
+    Word word{ERROR};
     
-    /// Detects if the grammar is empty
-    constexpr bool isNull() const
+    /// Threeway comparison
+    auto operator<=>(const GrammarAction& oth) const = default;
+    
+    /// Gets a shift action
+    static constexpr GrammarAction getShift(const size_t& iState)
     {
-      return
-	nSymbols==0 and
-	productionPars.isNull() and
-	nItems==0 and
-	stateItemsPars.isNull() and
-	stateTransitionsPars.isNull() and
-	regexMachinePars.isNull();
+      return {(Word)((iState<<nTypeBits)|SHIFT)};
+    }
+    
+    /// Gets a reduce action
+    static constexpr GrammarAction getReduce(const size_t& iProduction)
+    {
+      return {(Word)((iProduction<<nTypeBits)|REDUCE)};
+    }
+    
+    /// Type of the action
+    constexpr Type type() const
+    {
+      return (Type)(word&((1<<nTypeBits)-1));
+    }
+    
+    /// State to be shifted or production to be reduced
+    constexpr size_t iStateOrProduction() const
+    {
+      return word>>nTypeBits;
     }
   };
   
-  /// Base functionality of the gramamr
-  template <typename T>
-  struct BaseGrammar :
-    StaticPolymorphic<T>
+  /// Handler of the parser which only recognizes the input, without building any value
+  struct GrammarRecognizer
   {
-    /// Import the static polymorphism cast
-    using StaticPolymorphic<T>::self;
+    /// Empty value associated to each symbol
+    struct Value
+    {
+    };
+    
+    /// Shift a terminal symbol
+    constexpr Value shift(const size_t& /* iSymbol */,
+			  const std::string_view& /* matchedString */)
+    {
+      return {};
+    }
+    
+    /// Reduce a production
+    constexpr Value reduce(const size_t& /* iProduction */,
+			   const std::span<Value>& /* rhs */)
+    {
+      return {};
+    }
   };
   
-  /// Grammar with all the functions to create it
-  struct Grammar
+  /// Status of the parser after consuming some input
+  ///
+  /// The stack underflows when a reduction would pop its bottom
+  /// state, which can only happen when parsing from a speculated state
+  enum class GrammarParseStatus{NEED_MORE_INPUT,ACCEPT,ERROR,UNDERFLOW};
+  
+  /// Stacks of the parser, holding the states and the values of the symbols
+  ///
+  /// Each stack is a single contiguous buffer, which is cleared but
+  /// not released at the beginning of each parse, so that passing the
+  /// same stacks to subsequent parses avoids allocating them again
+  /// once they have grown to the needed depth
+  template <typename V>
+  struct GrammarParseStacks
   {
-    std::string_view name;
+    /// Stack of the states
+    std::vector<size_t> states;
     
-    std::vector<GrammarSymbol> symbols;
+    /// Stack of the values, one for each state but the first
+    std::vector<V> values;
     
-    size_t iStartSymbol{};
+    /// Empties the stacks, keeping the storage
+    constexpr void clear()
+    {
+      states.clear();
+      values.clear();
+    }
     
-    size_t iEndSymbol{};
+    /// Empties the stacks and sets the initial state
+    constexpr void restart()
+    {
+      clear();
+      states.push_back(0);
+    }
     
-    size_t iErrorSymbol{};
+    /// Reserves the storage for the given depth
+    constexpr void reserve(const size_t& depth)
+    {
+      states.reserve(depth+1);
+      values.reserve(depth);
+    }
+  };
+  
+  /// Piece of input parsed speculating the state in which the parser is at its beginning
+  template <typename V>
+  struct GrammarParsedPiece
+  {
+    /// Position where the piece begins
+    size_t begin;
     
-    size_t iWhitespaceSymbol{};
+    /// Position up to which the piece has been parsed
+    size_t end;
     
-    size_t currentPrecedence{};
+    /// Stacks resulting from parsing the piece, the bottom state being the speculated one
+    GrammarParseStacks<V> stacks;
+  };
+  
+  /// Size of the cache lines, assumed to avoid depending on the value guessed by the compiler
+  inline constexpr size_t cacheLineSize=64;
+  
+  /// Bounded ring passing elements from a single producer thread to a single consumer one
+  ///
+  /// The indices written by each side lie on separate cache lines,
+  /// and are published to the other side only once every batch of
+  /// elements, or when the side would otherwise have to wait, so
+  /// that the cache lines bounce between the cores once per batch
+  template <typename E>
+  struct SingleProducerSingleConsumerRing
+  {
+    /// Storage of the elements
+    std::vector<E> slots;
     
-    std::vector<GrammarProduction> productions;
+    /// Mask giving the slot of an index
+    const size_t mask;
     
-    std::vector<std::string_view> whitespaceRegexList;
+    /// Number of elements after which the indices are published
+    const size_t publicationBatch;
     
-    std::vector<GrammarItem> items;
+    /// Index of the next element to be pushed, as published by the producer
+    alignas(cacheLineSize) std::atomic<size_t> head{0};
     
-    std::vector<GrammarState> stateItems;
+    /// Index of the next element to be pushed
+    size_t producerHead{0};
     
-    std::vector<std::vector<GrammarTransition>> stateTransitions;
+    /// Index of the next element to be popped, as last seen by the producer
+    size_t producerTail{0};
     
-    std::vector<Lookahead> lookaheads;
+    /// Index of the next element to be popped, as published by the consumer
+    alignas(cacheLineSize) std::atomic<size_t> tail{0};
     
-    RegexMatcher regexMatcher;
+    /// Index of the next element to be popped
+    size_t consumerTail{0};
     
-    std::vector<size_t> iSymbolOfRegex;
+    /// Index of the next element to be pushed, as last seen by the consumer
+    size_t consumerHead{0};
     
-    /// Describes a production
-    constexpr inline std::string describe(const GrammarProduction& production) const
-    {
-      return production.describe(symbols);
-    }
+    /// Set by the consumer when it stops popping
+    alignas(cacheLineSize) std::atomic<bool> abandoned{false};
     
-    /// Describes an item
-    constexpr inline std::string describe(const GrammarItem& item) const
+    /// Creates the ring with the given capacity, which must be a power of two
+    SingleProducerSingleConsumerRing(const size_t& capacity,
+				     const size_t& publicationBatch) :
+      slots(capacity),
+      mask(capacity-1),
+      publicationBatch(publicationBatch)
     {
-      return item.describe(productions,symbols);
+      if(not std::has_single_bit(capacity) or publicationBatch>capacity)
+	errorEmitter("The capacity of the ring must be a power of two not smaller than the publication batch");
     }
     
-    /// Describes the state
-    constexpr inline std::string describe(const GrammarState& state,
-					  const std::string& pref="") const
+    /// Makes the pushed elements visible to the consumer
+    void publish()
     {
-      return state.describe(items,productions,symbols,pref);
+      head.store(producerHead,std::memory_order_release);
     }
     
-    /// Describes a transition
-    constexpr inline std::string describe(const GrammarTransition& transition) const
+    /// Pushes the element, waiting for a free slot, returning false if the consumer has abandoned the ring
+    bool push(const E& e)
     {
-      return transition.describe(items,productions,symbols,stateItems);
+      if(producerHead-producerTail==slots.size())
+	{
+	  publish();
+	  
+	  while((producerTail=tail.load(std::memory_order_acquire))==producerHead-slots.size())
+	    if(abandoned.load(std::memory_order_relaxed))
+	      return false;
+	    else
+	      std::this_thread::yield();
+	}
+      
+      slots[producerHead++&mask]=e;
+      
+      if(producerHead%publicationBatch==0)
+	{
+	  publish();
+	  
+	  return not abandoned.load(std::memory_order_relaxed);
+	}
+      
+      return true;
     }
     
-    /// Finds or insert a symbol
-    constexpr size_t insertOrFindSymbol(const std::string_view& name,
-					const GrammarSymbol::Type& type)
+    /// Pops the next element, waiting for it to be published
+    E pop()
     {
-      GrammarSymbol* s;
+      if(consumerTail==consumerHead)
+	{
+	  tail.store(consumerTail,std::memory_order_release);
+	  
+	  while((consumerHead=head.load(std::memory_order_acquire))==consumerTail)
+	    std::this_thread::yield();
+	}
       
-      if(auto ref=
-	 std::ranges::find_if(symbols,
-			      [&name,
-			       &type](const GrammarSymbol& s)
-			      {
-				return s.name==name and s.type==type;
-			      });ref!=symbols.end())
-	s=&(*ref);
-      else
-	s=&symbols.emplace_back(name,type);
+      /// Popped element
+      E e=std::move(slots[consumerTail++&mask]);
       
-      return std::distance(symbols.begin(),(std::vector<GrammarSymbol>::iterator)s);
+      if(consumerTail%publicationBatch==0)
+	tail.store(consumerTail,std::memory_order_release);
+      
+      return e;
     }
     
-    constexpr std::optional<size_t> matchAndParseSymbol(StringMatcher& m)
+    /// Tells the producer that no more element will be popped
+    void abandon()
     {
-      m.matchWhiteSpaceOrComments();
+      abandoned.store(true,std::memory_order_relaxed);
+    }
+  };
+  
+  /// Token stored compactly, referring to the input by position
+  struct GrammarCompactToken
+  {
+    /// Marks the tokens which could not be lexed
+    static constexpr uint32_t lexingError=
+      std::numeric_limits<uint32_t>::max();
+    
+    /// Position of the matched string in the input
+    size_t begin;
+    
+    /// Length of the matched string
+    uint32_t length;
+    
+    /// Symbol of the token, or lexingError
+    uint32_t iSymbol;
+  };
+  
+  /// Symbol associated to each character, when it forms a token by itself
+  using StructuralSymbolOfChar=
+    std::array<size_t,256>;
+  
+  /// Marks the characters which are not structural
+  inline constexpr size_t noStructuralSymbol=
+    std::numeric_limits<size_t>::max();
+  
+  /// Kind of string delimited by a character
+  enum class StringDelimiter : uint8_t{NONE,WITHOUT_ESCAPES,WITH_ESCAPES};
+  
+  /// Kind of string delimited by each character
+  using StringDelimiterOfChar=
+    std::array<StringDelimiter,256>;
+  
+  /// Positions of the structural characters of an input
+  ///
+  /// Structural characters always form a token by themselves, and
+  /// cannot appear inside any other token but the strings, so that
+  /// they can be located by classifying each character of the input,
+  /// and following the delimiters and the escapes of the strings,
+  /// without lexing
+  struct GrammarStructuralIndex
+  {
+    /// Positions of the structural characters
+    std::vector<size_t> positions;
+    
+    /// Characters classified by the vectorized search, kept to reuse the storage
+    std::vector<char> candidateChars;
+    
+#if defined(_PARSEPACT_X86)
+    /// Appends the positions of the candidate characters in blocks of 32 characters, returning the number of processed characters
+    __attribute__((target("avx2")))
+    static size_t findCandidatesAvx2(const std::string_view& input,
+				     const std::vector<char>& candidateChars,
+				     std::vector<size_t>& candidates)
+    {
+      /// Position of the block
+      size_t i=0;
       
-      if(m.matchStr("error"))
-	return iErrorSymbol;
-      else if(auto l=m.matchLiteral();not l.empty())
-	return insertOrFindSymbol(l,GrammarSymbol::Type::TERMINAL_SYMBOL);
-      else if(auto r=m.matchRegex();not r.empty())
-	return insertOrFindSymbol(r,GrammarSymbol::Type::TERMINAL_SYMBOL);
-      else if(auto i=m.matchId();not i.empty())
-	return insertOrFindSymbol(i,GrammarSymbol::Type::NON_TERMINAL_SYMBOL);
+      for(;i+32<=input.size();i+=32)
+	{
+	  /// Block of characters
+	  const __m256i block=_mm256_loadu_si256((const __m256i*)&input[i]);
+	  
+	  /// Characters of the block which are candidates
+	  __m256i isCandidate=_mm256_setzero_si256();
+	  for(const char& c : candidateChars)
+	    isCandidate=_mm256_or_si256(isCandidate,_mm256_cmpeq_epi8(block,_mm256_set1_epi8(c)));
+	  
+	  for(uint32_t mask=_mm256_movemask_epi8(isCandidate);mask;mask&=mask-1)
+	    candidates.push_back(i+std::countr_zero(mask));
+	}
       
-      return std::nullopt;
+      return i;
     }
+#endif
     
-    constexpr bool matchAndParseAssociativityStatement(StringMatcher& matchin)
+    /// Fills the index, reusing the storage
+    ///
+    /// The positions of the characters which are structural, delimit
+    /// a string, or escape the next character, are collected first.
+    /// The strings are then followed, dropping the positions of the
+    /// delimiters and of the characters inside them
+    constexpr void build(const std::string_view& input,
+			 const StructuralSymbolOfChar& iStructuralSymbolOfChar,
+			 const StringDelimiterOfChar& stringDelimiterOfChar)
     {
-      /// Undo if not matching
-      auto matchRes=
-	matchin.beginTemptativeMatch("associativityStatement",false);
+      positions.clear();
       
-      using enum GrammarSymbol::Associativity;
+      /// Determines whether any character delimits strings
+      bool hasStrings=false;
       
-      constexpr std::array<std::pair<std::string_view,GrammarSymbol::Associativity>,3>
-		  possibleAssociativities{std::make_pair("%none",NONE),
-					  std::make_pair("%left",LEFT),
-					  std::make_pair("%right",RIGHT)};
+      /// Determines whether the backslash escapes the next character in some string
+      bool hasEscapes=false;
       
-      matchin.matchWhiteSpaceOrComments();
+      for(const StringDelimiter& delimiter : stringDelimiterOfChar)
+	{
+	  hasStrings|=(delimiter!=StringDelimiter::NONE);
+	  hasEscapes|=(delimiter==StringDelimiter::WITH_ESCAPES);
+	}
       
-      size_t iAss=0;
-      while(iAss<possibleAssociativities.size() and
-	    not matchin.matchStr(possibleAssociativities[iAss].first))
-	iAss++;
+      /// Determines whether the character must be collected
+      const auto isCandidate=
+	[&iStructuralSymbolOfChar,
+	 &stringDelimiterOfChar,
+	 &hasEscapes](const char& c)
+	{
+	  return
+	    iStructuralSymbolOfChar[(unsigned char)c]!=noStructuralSymbol or
+	    stringDelimiterOfChar[(unsigned char)c]!=StringDelimiter::NONE or
+	    (hasEscapes and c=='\\');
+	};
       
-      if(iAss!=possibleAssociativities.size())
+      /// Position of the first character to be processed by the scalar loop
+      size_t i=0;
+      
+#if defined(_PARSEPACT_X86)
+      if(not std::is_constant_evaluated() and cpuSupportsAvx2())
 	{
-	  diagnostic("Matched ",possibleAssociativities[iAss].first.begin()," associativity\n");
+	  candidateChars.clear();
+	  for(size_t c=0;c<256;c++)
+	    if(isCandidate((char)c))
+	      candidateChars.push_back((char)c);
 	  
-	  GrammarSymbol::Associativity currentAssociativity=possibleAssociativities[iAss].second;
-	  currentPrecedence++;
+	  i=findCandidatesAvx2(input,candidateChars,positions);
+	}
+#endif
+      
+      for(;i<input.size();i++)
+	if(isCandidate(input[i]))
+	  positions.push_back(i);
+      
+      if(hasStrings)
+	{
+	  /// Number of positions kept
+	  size_t nKept=0;
 	  
-	  while(auto m=matchAndParseSymbol(matchin))
+	  /// Determines whether the position is inside a string
+	  bool inString=false;
+	  
+	  /// Delimiter of the current string
+	  char openingDelimiter='\0';
+	  
+	  /// Position of the escaped character, if any
+	  size_t escapedPos=input.size();
+	  
+	  for(size_t iCandidate=0;iCandidate<positions.size();iCandidate++)
 	    {
-	      GrammarSymbol& s=symbols[*m];
-	      diagnostic("Matched symbol: \"",name,"\"\n");
+	      /// Position of the candidate
+	      const size_t pos=positions[iCandidate];
 	      
-	      s.associativity=currentAssociativity;
-	      s.precedence=currentPrecedence;
+	      /// Candidate character
+	      const char c=input[pos];
+	      
+	      if(inString)
+		{
+		  if(pos==escapedPos)
+		    escapedPos=input.size();
+		  else
+		    if(c==openingDelimiter)
+		      inString=false;
+		    else
+		      if(c=='\\' and stringDelimiterOfChar[(unsigned char)openingDelimiter]==StringDelimiter::WITH_ESCAPES)
+			escapedPos=pos+1;
+		}
+	      else
+		if(stringDelimiterOfChar[(unsigned char)c]!=StringDelimiter::NONE)
+		  {
+		    inString=true;
+		    openingDelimiter=c;
+		  }
+		else
+		  if(iStructuralSymbolOfChar[(unsigned char)c]!=noStructuralSymbol)
+		    positions[nKept++]=pos;
 	    }
 	  
-	  matchin.matchWhiteSpaceOrComments();
-	  
-	  if((matchRes.state=matchin.matchChar(';')))
-	    diagnostic("Matched associativity statement end\n");
-	  else
-	    errorEmitter("Unterminated associativity statement");
+	  positions.resize(nKept);
 	}
-      
-      return matchRes;
     }
+  };
+  
+  /// String spanning from the begin of the first to the end of the second, any of which can be empty
+  constexpr std::string_view spanningString(const std::string_view& first,
+					    const std::string_view& second)
+  {
+    if(first.empty())
+      return second;
+    else
+      if(second.empty())
+	return first;
+      else
+	return std::string_view(first.data(),second.data()+second.size()-first.data());
+  }
+  
+  /// Node of the concrete syntax tree
+  struct GrammarTreeNode
+  {
+    /// Production marking the nodes of the terminal symbols
+    static constexpr size_t noProduction=std::numeric_limits<size_t>::max();
     
-    constexpr bool matchAndParseProductionStatement(StringMatcher& matchin)
-    {
-      auto matchRes=
-	matchin.beginTemptativeMatch("productionStatement",false);
-      
+    /// Production reduced into the node, or noProduction for terminal symbols
+    size_t iProduction;
+    
+    /// Terminal symbol or lhs of the production
+    size_t iSymbol;
+    
+    /// Position of the first child in the list of children of the tree
+    size_t iFirstChild;
+    
+    /// Number of children
+    size_t nChildren;
+    
+    /// Matched string, spanning the tokens of all the children
+    std::string_view str;
+    
+    /// Determines whether the node corresponds to a terminal symbol
+    constexpr bool isToken() const
+    {
+      return iProduction==noProduction;
+    }
+  };
+  
+  /// Concrete syntax tree, stored in flat arrays
+  ///
+  /// The nodes are laid out in postfix order, each node following its
+  /// children, and the root being the last node. The children of each
+  /// node are listed contiguously in a separate array. The storage,
+  /// including the parser stacks, is kept when clearing, so that
+  /// reusing the tree for subsequent parses does not allocate again,
+  /// and clearing takes constant time
+  struct GrammarTree
+  {
+    /// Nodes of the tree
+    std::vector<GrammarTreeNode> nodes;
+    
+    /// Index of the children of the nodes
+    std::vector<size_t> children;
+    
+    /// Stacks used to parse
+    GrammarParseStacks<size_t> stacks;
+    
+    /// Removes all nodes, keeping the storage
+    constexpr void clear()
+    {
+      nodes.clear();
+      children.clear();
+      stacks.clear();
+    }
+    
+    /// Index of the children of the node
+    constexpr std::span<const size_t> childrenOf(const size_t& iNode) const
+    {
+      /// Node whose children are returned
+      const GrammarTreeNode& node=nodes[iNode];
+      
+      return {children.begin()+node.iFirstChild,node.nChildren};
+    }
+  };
+  
+  /// Handler of the parser forwarding the shifts and the reductions as events to a listener
+  ///
+  /// The listener can define onShift(iSymbol,matchedString), called
+  /// when a token is shifted, and onReduce(iProduction,matchedString),
+  /// called when a production is reduced, with the string spanned by
+  /// the rhs. Only the string spanned by each symbol in the parser
+  /// stack is kept, so that the memory is proportional to the nesting
+  /// depth rather than to the length of the input. Defining either of
+  /// the two methods with different arguments is a compile error,
+  /// rather than a silently ignored event
+  template <typename L>
+  struct GrammarEventsForwarder
+  {
+    /// String spanned by each symbol
+    using Value=std::string_view;
+    
+    /// Listener of the events
+    L& listener;
+    
+    /// Determines whether the listener defines onShift, but not callable with the documented arguments
+    static constexpr bool hasMismatchedOnShift=
+      requires{&L::onShift;} and
+      not requires(L& listener,const size_t& iSymbol,const std::string_view& matchedString)
+      {
+	listener.onShift(iSymbol,matchedString);
+      };
+    
+    /// Determines whether the listener defines onReduce, but not callable with the documented arguments
+    static constexpr bool hasMismatchedOnReduce=
+      requires{&L::onReduce;} and
+      not requires(L& listener,const size_t& iProduction,const std::string_view& matchedString)
+      {
+	listener.onReduce(iProduction,matchedString);
+      };
+    
+    static_assert(not hasMismatchedOnShift,"The onShift method of the listener must be callable with (iSymbol,matchedString)");
+    
+    static_assert(not hasMismatchedOnReduce,"The onReduce method of the listener must be callable with (iProduction,matchedString)");
+    
+    /// Forwards the shift of a terminal symbol
+    constexpr std::string_view shift(const size_t& iSymbol,
+				     const std::string_view& matchedString)
+    {
+      if constexpr(requires{listener.onShift(iSymbol,matchedString);})
+	listener.onShift(iSymbol,matchedString);
+      
+      return matchedString;
+    }
+    
+    /// Forwards the reduction of a production
+    constexpr std::string_view reduce(const size_t& iProduction,
+				      const std::span<std::string_view>& rhs)
+    {
+      /// String spanned by the rhs
+      std::string_view str;
+      
+      for(const std::string_view& rhsStr : rhs)
+	str=spanningString(str,rhsStr);
+      
+      if constexpr(requires{listener.onReduce(iProduction,str);})
+	listener.onReduce(iProduction,str);
+      
+      return str;
+    }
+  };
+  
+  /// Parser fed with the input one chunk at a time
+  ///
+  /// The parser stacks, the state of the lexer and the partial lexeme
+  /// are kept between the chunks, so that each parse only needs a few
+  /// small buffers, and many parses can share the same grammar. The
+  /// matched strings passed to the handler are only valid during the
+  /// call, as they can refer to the internal copy of a lexeme split
+  /// across chunks
+  template <typename G,
+	    typename H>
+  struct GrammarPushParser
+  {
+    /// Type of the values associated to the symbols
+    using Value=typename H::Value;
+    
+    /// Grammar used to parse
+    const G& grammar;
+    
+    /// Handler of the shifts and reductions
+    H handler;
+    
+    /// Stacks of the parser
+    GrammarParseStacks<Value> stacks;
+    
+    /// State of the lexer
+    size_t dState;
+    
+    /// Lexeme matched so far, carried over from the previous chunks
+    std::string lexeme;
+    
+    /// Current status
+    GrammarParseStatus status;
+    
+    /// Creates the parser, ready to parse a new input
+    constexpr GrammarPushParser(const G& grammar,
+				H handler) :
+      grammar(grammar),
+      handler(std::move(handler))
+    {
+      restart();
+    }
+    
+    /// Prepares to parse a new input, keeping the storage
+    constexpr void restart()
+    {
+      stacks.restart();
+      dState=0;
+      lexeme.clear();
+      status=GrammarParseStatus::NEED_MORE_INPUT;
+    }
+    
+    /// Passes the token matched by the lexer to the parser, skipping the whitespaces
+    constexpr void emitToken(const std::string_view& matchedString)
+    {
+      if(const std::optional<size_t> iToken=grammar.regexMatcher.acceptedToken(dState);not iToken or matchedString.empty())
+	status=GrammarParseStatus::ERROR;
+      else
+	if(*iToken!=grammar.iWhitespaceSymbol)
+	  status=grammar.consumeToken({*iToken,matchedString},handler,stacks);
+      
+      dState=0;
+      lexeme.clear();
+    }
+    
+    /// Feeds the next chunk of input
+    constexpr GrammarParseStatus push(const std::string_view& chunk)
+    {
+      /// Position where the part of the lexeme contained in the chunk begins
+      size_t iLexemeBegin=0;
+      
+      for(size_t i=0;i<chunk.size() and status==GrammarParseStatus::NEED_MORE_INPUT;)
+	if(const std::optional<size_t> next=grammar.regexMatcher.nextDState(dState,chunk[i]))
+	  {
+	    dState=*next;
+	    i++;
+	  }
+	else
+	  {
+	    if(lexeme.empty())
+	      emitToken(chunk.substr(iLexemeBegin,i-iLexemeBegin));
+	    else
+	      {
+		lexeme.append(chunk.substr(iLexemeBegin,i-iLexemeBegin));
+		emitToken(lexeme);
+	      }
+	    
+	    iLexemeBegin=i;
+	  }
+      
+      if(status==GrammarParseStatus::NEED_MORE_INPUT)
+	lexeme.append(chunk.substr(iLexemeBegin));
+      
+      return status;
+    }
+    
+    /// Marks the end of the input, returning whether the whole input has been accepted
+    constexpr GrammarParseStatus finish()
+    {
+      if(status==GrammarParseStatus::NEED_MORE_INPUT and not lexeme.empty())
+	emitToken(lexeme);
+      
+      if(status==GrammarParseStatus::NEED_MORE_INPUT)
+	status=grammar.consumeToken({grammar.iEndSymbol,std::string_view{}},handler,stacks);
+      
+      if(status==GrammarParseStatus::NEED_MORE_INPUT)
+	status=GrammarParseStatus::ERROR;
+      
+      return status;
+    }
+    
+    /// Value of the start symbol, valid once the input has been accepted
+    constexpr Value& result()
+    {
+      return stacks.values.back();
+    }
+  };
+  
+  /// Event produced while parsing asynchronously
+  struct GrammarParseEvent
+  {
+    /// Possible types of event
+    enum Type{SHIFT,REDUCE,ACCEPT,ERROR};
+    
+    /// Type of the event
+    Type type;
+    
+    /// Symbol shifted, or production reduced
+    size_t iSymbolOrProduction;
+    
+    /// String matched by the shifted symbol
+    std::string_view matchedString;
+  };
+  
+  /// Handler of the parser recording the shifts and reductions of a chunk of input as events
+  ///
+  /// The lexemes not contained in the chunk, having been split across
+  /// chunks, are copied, so that the events can be consumed after the
+  /// chunk has been parsed. At most one such lexeme is emitted per
+  /// chunk, the one started in the previous chunks
+  struct GrammarEventRecorder
+  {
+    /// No value is associated to the symbols
+    using Value=GrammarRecognizer::Value;
+    
+    /// Events recorded since last cleared
+    std::vector<GrammarParseEvent> events;
+    
+    /// Chunk of input being parsed
+    std::string_view chunk;
+    
+    /// Copy of the lexeme split across chunks
+    std::string carriedLexeme;
+    
+    /// Records the shift of a terminal symbol
+    constexpr Value shift(const size_t& iSymbol,
+			  const std::string_view& matchedString)
+    {
+      if(matchedString.data()>=chunk.data() and matchedString.data()<chunk.data()+chunk.size())
+	events.push_back({GrammarParseEvent::SHIFT,iSymbol,matchedString});
+      else
+	{
+	  carriedLexeme=matchedString;
+	  events.push_back({GrammarParseEvent::SHIFT,iSymbol,carriedLexeme});
+	}
+      
+      return {};
+    }
+    
+    /// Records the reduction of a production
+    constexpr Value reduce(const size_t& iProduction,
+			   const std::span<Value>& /* rhs */)
+    {
+      events.push_back({GrammarParseEvent::REDUCE,iProduction,{}});
+      
+      return {};
+    }
+  };
+  
+  /// Asynchronous generator of the parse events
+  ///
+  /// The consumer obtains each event awaiting next(), and is resumed
+  /// as soon as the generator yields it, or ends. The generator is in
+  /// turn suspended while awaiting the input, and resumed by the input
+  /// source when it is available
+  struct GrammarEventGenerator
+  {
+    /// Promise of the coroutine
+    struct promise_type
+    {
+      /// Last yielded event
+      GrammarParseEvent event;
+      
+      /// Coroutine awaiting the next event
+      std::coroutine_handle<> consumer;
+      
+      /// Transfers the control to the consumer
+      struct ResumeConsumer
+      {
+	/// Always suspend the generator
+	bool await_ready() noexcept
+	{
+	  return false;
+	}
+	
+	/// Resumes the consumer
+	std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> handle) noexcept
+	{
+	  return handle.promise().consumer;
+	}
+	
+	/// Nothing to return
+	void await_resume() noexcept
+	{
+	}
+      };
+      
+      /// Creates the generator
+      GrammarEventGenerator get_return_object()
+      {
+	return GrammarEventGenerator(std::coroutine_handle<promise_type>::from_promise(*this));
+      }
+      
+      /// Waits for the first event to be requested
+      std::suspend_always initial_suspend() noexcept
+      {
+	return {};
+      }
+      
+      /// Resumes the consumer at the end
+      ResumeConsumer final_suspend() noexcept
+      {
+	return {};
+      }
+      
+      /// Stores the event and resumes the consumer
+      ResumeConsumer yield_value(const GrammarParseEvent& yieldedEvent)
+      {
+	event=yieldedEvent;
+	
+	return {};
+      }
+      
+      /// Nothing to return
+      void return_void()
+      {
+      }
+      
+      /// Exceptions cannot be propagated to the consumer
+      void unhandled_exception()
+      {
+	std::terminate();
+      }
+    };
+    
+    /// Handle to the coroutine
+    std::coroutine_handle<promise_type> handle;
+    
+    /// Awaiter of the next event
+    struct NextEvent
+    {
+      /// Handle to the generator
+      std::coroutine_handle<promise_type> handle;
+      
+      /// Does not suspend if the generator is over
+      bool await_ready() const
+      {
+	return handle.done();
+      }
+      
+      /// Resumes the generator, recording the consumer
+      std::coroutine_handle<> await_suspend(std::coroutine_handle<> consumer)
+      {
+	handle.promise().consumer=consumer;
+	
+	return handle;
+      }
+      
+      /// Returns the yielded event, or nothing if the generator is over
+      std::optional<GrammarParseEvent> await_resume() const
+      {
+	if(handle.done())
+	  return {};
+	else
+	  return handle.promise().event;
+      }
+    };
+    
+    /// Awaits for the next event
+    NextEvent next()
+    {
+      return {handle};
+    }
+    
+    /// Takes ownership of the coroutine
+    explicit GrammarEventGenerator(const std::coroutine_handle<promise_type>& handle) :
+      handle(handle)
+    {
+    }
+    
+    /// Move constructor
+    GrammarEventGenerator(GrammarEventGenerator&& oth) :
+      handle(std::exchange(oth.handle,{}))
+    {
+    }
+    
+    /// Destroys the coroutine
+    ~GrammarEventGenerator()
+    {
+      if(handle)
+	handle.destroy();
+    }
+  };
+  
+  /// Handler of the parser recording the concrete syntax tree
+  ///
+  /// The value of each symbol is the index of its node. The unit
+  /// productions bypassed by the parse tables do not produce a node
+  template <typename G>
+  struct GrammarTreeBuilder
+  {
+    /// Index of the node associated to each symbol
+    using Value=size_t;
+    
+    /// Grammar used to parse
+    const G& grammar;
+    
+    /// Tree being built
+    GrammarTree& tree;
+    
+    /// Adds the node of a terminal symbol
+    constexpr size_t shift(const size_t& iSymbol,
+			   const std::string_view& matchedString)
+    {
+      tree.nodes.push_back({.iProduction=GrammarTreeNode::noProduction,
+			    .iSymbol=iSymbol,
+			    .iFirstChild=tree.children.size(),
+			    .nChildren=0,
+			    .str=matchedString});
+      
+      return tree.nodes.size()-1;
+    }
+    
+    /// Adds the node of the production, with the rhs as children
+    constexpr size_t reduce(const size_t& iProduction,
+			    const std::span<size_t>& rhs)
+    {
+      /// String spanned by the children
+      std::string_view str;
+      
+      for(const size_t& iChild : rhs)
+	str=spanningString(str,tree.nodes[iChild].str);
+      
+      tree.nodes.push_back({.iProduction=iProduction,
+			    .iSymbol=grammar.iLhsOfProduction(iProduction),
+			    .iFirstChild=tree.children.size(),
+			    .nChildren=rhs.size(),
+			    .str=str});
+      
+      tree.children.insert(tree.children.end(),rhs.begin(),rhs.end());
+      
+      return tree.nodes.size()-1;
+    }
+  };
+  
+  /// Sizes defining the compressed parse tables
+  struct GrammarParseTablesSizes
+  {
+    /// Number of symbols
+    const size_t nSymbols;
+    
+    /// Number of states
+    const size_t nStates;
+    
+    /// Number of non-terminal symbols
+    const size_t nNonTerminals;
+    
+    /// Number of entries of the packed action table
+    const size_t nActionEntries;
+    
+    /// Number of entries of the packed goto table
+    const size_t nGotoEntries;
+    
+    /// Detects if the tables are empty
+    constexpr bool isNull() const
+    {
+      return nSymbols==0 and nStates==0 and nNonTerminals==0 and nActionEntries==0 and nGotoEntries==0;
+    }
+  };
+  
+  /// Base functionality of the compressed parse tables
+  ///
+  /// Terminal symbols are renumbered from zero in the action table,
+  /// non-terminal ones in the goto table. Each table overlaps its rows
+  /// in a single vector, displacing each row by its base, and checks
+  /// that the entry belongs to the row being looked up. The entries of
+  /// the default reduction of each state are not stored, and the states
+  /// in which it is the only action do not need the lookahead
+  template <typename T>
+  struct BaseGrammarParseTables :
+    StaticPolymorphic<T>
+  {
+    /// Import the static polymorphism cast
+    using StaticPolymorphic<T>::self;
+    
+    /// Action to be taken in the state for the lookahead symbol
+    constexpr GrammarAction action(const size_t& iState,
+				   const size_t& iSymbol) const
+    {
+      /// Position of the entry in the packed table
+      const size_t i=self().actionBase[iState]+self().indexOfSymbol[iSymbol];
+      
+      if(self().actionCheck[i]==iState)
+	return self().actionEntries[i];
+      else
+	return self().defaultActions[iState];
+    }
+    
+    /// Determines whether the lookahead is needed to decide the action in the state
+    constexpr bool needsLookahead(const size_t& iState) const
+    {
+      return self().lookaheadNeeded[iState];
+    }
+    
+    /// Action to be taken in the state regardless of the lookahead
+    constexpr GrammarAction defaultAction(const size_t& iState) const
+    {
+      return self().defaultActions[iState];
+    }
+    
+    /// State reached from the state after reducing to the non-terminal symbol
+    constexpr size_t gotoState(const size_t& iState,
+			       const size_t& iSymbol) const
+    {
+      /// Index of the non-terminal
+      const size_t& iNonTerminal=self().indexOfSymbol[iSymbol];
+      
+      /// Position of the entry in the packed table
+      const size_t i=self().gotoBase[iNonTerminal]+iState;
+      
+      if(self().gotoCheck[i]==iNonTerminal)
+	return self().gotoEntries[i];
+      else
+	return self().defaultGoto[iNonTerminal];
+    }
+  };
+  
+  /// Compressed parse tables, built from the transitions
+  struct GrammarParseTables :
+    BaseGrammarParseTables<GrammarParseTables>
+  {
+    /// Type used to store the packed entries
+    using Word=GrammarAction::Word;
+    
+    /// Value marking the entries not belonging to any row
+    static constexpr Word noRow=std::numeric_limits<Word>::max();
+    
+    /// Index of each symbol among the terminal or the non-terminal ones
+    std::vector<Word> indexOfSymbol;
+    
+    /// Displacement of the row of each state in the action table
+    std::vector<Word> actionBase;
+    
+    /// State owning each entry of the action table
+    std::vector<Word> actionCheck;
+    
+    /// Packed actions
+    std::vector<GrammarAction> actionEntries;
+    
+    /// Action of each state for the lookaheads not in the action table
+    std::vector<GrammarAction> defaultActions;
+    
+    /// Determines whether each state needs the lookahead to decide the action
+    std::vector<bool> lookaheadNeeded;
+    
+    /// Displacement of the row of each non-terminal in the goto table
+    std::vector<Word> gotoBase;
+    
+    /// Non-terminal owning each entry of the goto table
+    std::vector<Word> gotoCheck;
+    
+    /// Packed goto states
+    std::vector<Word> gotoEntries;
+    
+    /// Most frequent goto state of each non-terminal, removed from the packed table
+    std::vector<Word> defaultGoto;
+    
+    /// Packs the rows, each given as list of column and value, into
+    /// the displaced table, setting the base of each row
+    template <typename V>
+    static constexpr void packRows(const std::vector<std::vector<std::pair<size_t,V>>>& rows,
+				   const size_t& nColumns,
+				   std::vector<Word>& base,
+				   std::vector<Word>& check,
+				   std::vector<V>& entries)
+    {
+      base.assign(rows.size(),0);
+      
+      /// Rows sorted by decreasing number of entries, which are the most difficult to fit
+      std::vector<size_t> iRows(rows.size());
+      std::iota(iRows.begin(),iRows.end(),0);
+      std::sort(iRows.begin(),iRows.end(),
+		[&rows](const size_t& a,
+			const size_t& b)
+		{
+		  return rows[a].size()>rows[b].size() or (rows[a].size()==rows[b].size() and a<b);
+		});
+      
+      /// First entry which might be free
+      size_t firstFree=0;
+      
+      for(const size_t& iRow : iRows)
+	if(const std::vector<std::pair<size_t,V>>& row=rows[iRow];not row.empty())
+	  {
+	    /// Searched displacement, starting from the first one possibly filling the first free entry
+	    size_t displacement=(firstFree>row.front().first)?(firstFree-row.front().first):0;
+	    
+	    const auto fits=
+	      [&check,
+	       &row](const size_t& displacement)
+	      {
+		for(const auto& [iColumn,value] : row)
+		  if(displacement+iColumn<check.size() and check[displacement+iColumn]!=noRow)
+		    return false;
+		
+		return true;
+	      };
+	    
+	    while(not fits(displacement))
+	      displacement++;
+	    
+	    if(displacement+nColumns>check.size())
+	      {
+		check.resize(displacement+nColumns,noRow);
+		entries.resize(displacement+nColumns);
+	      }
+	    
+	    base[iRow]=displacement;
+	    for(const auto& [iColumn,value] : row)
+	      {
+		check[displacement+iColumn]=iRow;
+		entries[displacement+iColumn]=value;
+	      }
+	    
+	    while(firstFree<check.size() and check[firstFree]!=noRow)
+	      firstFree++;
+	  }
+      
+      // Allows the lookup of any column of the empty rows
+      if(check.size()<nColumns)
+	{
+	  check.resize(nColumns,noRow);
+	  entries.resize(nColumns);
+	}
+    }
+    
+    /// Default constructor
+    constexpr GrammarParseTables()=default;
+    
+    /// Builds from the transitions and the default reduction of each state
+    constexpr GrammarParseTables(const std::vector<std::vector<GrammarTransition>>& stateTransitions,
+				 const std::vector<std::optional<size_t>>& iDefaultReductionOfState,
+				 const std::vector<GrammarSymbol>& symbols,
+				 const size_t& nProductions)
+    {
+      /// Number of terminal and non-terminal symbols
+      size_t nTerminals=0,nNonTerminals=0;
+      
+      for(const GrammarSymbol& symbol : symbols)
+	indexOfSymbol.push_back((symbol.type==GrammarSymbol::Type::NON_TERMINAL_SYMBOL)?nNonTerminals++:nTerminals++);
+      
+      /// Number of states
+      const size_t nStates=stateTransitions.size();
+      
+      if(std::max(nStates,nProductions)>=GrammarAction::nTargets)
+	errorEmitter("too many states or productions to be packed in the parse table actions");
+      
+      if(std::max(nStates,symbols.size())>=noRow)
+	errorEmitter("grammar too large to be packed in the parse tables");
+      
+      /// Actions of each state, indexed by terminal
+      std::vector<std::vector<std::pair<size_t,GrammarAction>>> actionRows(nStates);
+      
+      /// Goto states of each non-terminal, indexed by state
+      std::vector<std::vector<std::pair<size_t,Word>>> gotoRows(nNonTerminals);
+      
+      defaultActions.resize(nStates);
+      lookaheadNeeded.resize(nStates);
+      
+      for(size_t iState=0;iState<nStates;iState++)
+	{
+	  /// Default reduction of the state
+	  const std::optional<size_t>& iDefaultReduction=iDefaultReductionOfState[iState];
+	  
+	  if(iDefaultReduction)
+	    defaultActions[iState]=GrammarAction::getReduce(*iDefaultReduction);
+	  
+	  for(const GrammarTransition& transition : stateTransitions[iState])
+	    if(const size_t& index=indexOfSymbol[transition.iSymbol];symbols[transition.iSymbol].type==GrammarSymbol::Type::NON_TERMINAL_SYMBOL)
+	      gotoRows[index].emplace_back(iState,transition.iStateOrProduction);
+	    else
+	      if(transition.type==GrammarTransition::SHIFT)
+		actionRows[iState].emplace_back(index,GrammarAction::getShift(transition.iStateOrProduction));
+	      else
+		if(transition.iStateOrProduction!=iDefaultReduction)
+		  actionRows[iState].emplace_back(index,GrammarAction::getReduce(transition.iStateOrProduction));
+	  
+	  lookaheadNeeded[iState]=not (iDefaultReduction and actionRows[iState].empty());
+	}
+      
+      for(std::vector<std::pair<size_t,GrammarAction>>& row : actionRows)
+	std::sort(row.begin(),row.end(),
+		  [](const auto& a,
+		     const auto& b)
+		  {
+		    return a.first<b.first;
+		  });
+      
+      // Removes the most frequent goto state of each non-terminal
+      defaultGoto.assign(nNonTerminals,0);
+      for(size_t iNonTerminal=0;iNonTerminal<nNonTerminals;iNonTerminal++)
+	if(std::vector<std::pair<size_t,Word>>& row=gotoRows[iNonTerminal];not row.empty())
+	  {
+	    /// Goto states sorted to count their frequency
+	    std::vector<Word> gotoStates;
+	    for(const auto& [iState,iGotoState] : row)
+	      gotoStates.push_back(iGotoState);
+	    std::sort(gotoStates.begin(),gotoStates.end());
+	    
+	    /// Most frequent goto state and its frequency
+	    std::pair<Word,size_t> mostFrequent{};
+	    for(size_t i=0,j;i<gotoStates.size();i=j)
+	      {
+		for(j=i;j<gotoStates.size() and gotoStates[j]==gotoStates[i];j++);
+		
+		if(j-i>mostFrequent.second)
+		  mostFrequent={gotoStates[i],j-i};
+	      }
+	    
+	    defaultGoto[iNonTerminal]=mostFrequent.first;
+	    std::erase_if(row,[&mostFrequent](const std::pair<size_t,Word>& entry)
+	    {
+	      return entry.second==mostFrequent.first;
+	    });
+	  }
+      
+      packRows(actionRows,nTerminals,actionBase,actionCheck,actionEntries);
+      packRows(gotoRows,nStates,gotoBase,gotoCheck,gotoEntries);
+      
+      diagnostic("Action table packed in ",actionEntries.size()," entries for ",nStates," states and ",nTerminals," terminals\n");
+      diagnostic("Goto table packed in ",gotoEntries.size()," entries for ",nNonTerminals," non-terminals and ",nStates," states\n");
+    }
+    
+    /// Gets the parameters needed to build the constexpr tables
+    constexpr GrammarParseTablesSizes getSizes() const
+    {
+      return {.nSymbols=indexOfSymbol.size(),
+	      .nStates=actionBase.size(),
+	      .nNonTerminals=gotoBase.size(),
+	      .nActionEntries=actionEntries.size(),
+	      .nGotoEntries=gotoEntries.size()};
+    }
+  };
+  
+  /// Compressed parse tables stored in fixed size arrays
+  template <GrammarParseTablesSizes Sizes>
+  struct GrammarParseTablesCt :
+    BaseGrammarParseTables<GrammarParseTablesCt<Sizes>>
+  {
+    /// Type used to store the packed entries
+    using Word=GrammarAction::Word;
+    
+    /// Index of each symbol among the terminal or the non-terminal ones
+    std::array<Word,Sizes.nSymbols> indexOfSymbol;
+    
+    /// Displacement of the row of each state in the action table
+    std::array<Word,Sizes.nStates> actionBase;
+    
+    /// State owning each entry of the action table
+    std::array<Word,Sizes.nActionEntries> actionCheck;
+    
+    /// Packed actions
+    std::array<GrammarAction,Sizes.nActionEntries> actionEntries;
+    
+    /// Action of each state for the lookaheads not in the action table
+    std::array<GrammarAction,Sizes.nStates> defaultActions;
+    
+    /// Determines whether each state needs the lookahead to decide the action
+    std::array<bool,Sizes.nStates> lookaheadNeeded;
+    
+    /// Displacement of the row of each non-terminal in the goto table
+    std::array<Word,Sizes.nNonTerminals> gotoBase;
+    
+    /// Non-terminal owning each entry of the goto table
+    std::array<Word,Sizes.nGotoEntries> gotoCheck;
+    
+    /// Packed goto states
+    std::array<Word,Sizes.nGotoEntries> gotoEntries;
+    
+    /// Most frequent goto state of each non-terminal, removed from the packed table
+    std::array<Word,Sizes.nNonTerminals> defaultGoto;
+    
+    /// Default constructor
+    constexpr GrammarParseTablesCt()=default;
+    
+    /// Create from dynamic-sized tables
+    constexpr GrammarParseTablesCt(const GrammarParseTables& oth)
+    {
+      std::copy(oth.indexOfSymbol.begin(),oth.indexOfSymbol.end(),indexOfSymbol.begin());
+      std::copy(oth.actionBase.begin(),oth.actionBase.end(),actionBase.begin());
+      std::copy(oth.actionCheck.begin(),oth.actionCheck.end(),actionCheck.begin());
+      std::copy(oth.actionEntries.begin(),oth.actionEntries.end(),actionEntries.begin());
+      std::copy(oth.defaultActions.begin(),oth.defaultActions.end(),defaultActions.begin());
+      std::copy(oth.lookaheadNeeded.begin(),oth.lookaheadNeeded.end(),lookaheadNeeded.begin());
+      std::copy(oth.gotoBase.begin(),oth.gotoBase.end(),gotoBase.begin());
+      std::copy(oth.gotoCheck.begin(),oth.gotoCheck.end(),gotoCheck.begin());
+      std::copy(oth.gotoEntries.begin(),oth.gotoEntries.end(),gotoEntries.begin());
+      std::copy(oth.defaultGoto.begin(),oth.defaultGoto.end(),defaultGoto.begin());
+    }
+  };
+  
+  /// Specifications of the grammar
+  struct GrammarSpecs
+  {
+    /// Number of symbols
+    const size_t nSymbols;
+    
+    const Stack2DVectorPars productionPars;
+    
+    const size_t nItems;
+    
+    const Stack2DVectorPars stateItemsPars;
+    
+    const Stack2DVectorPars stateTransitionsPars;
+    
+    const RegexMatcherSizes regexMachinePars;
+    
+    const GrammarParseTablesSizes parseTablesPars;
+    
+    /// Detects if the grammar is empty
+    constexpr bool isNull() const
+    {
+      return
+	nSymbols==0 and
+	productionPars.isNull() and
+	nItems==0 and
+	stateItemsPars.isNull() and
+	stateTransitionsPars.isNull() and
+	regexMachinePars.isNull() and
+	parseTablesPars.isNull();
+    }
+  };
+  
+  /// Base functionality of the gramamr
+  template <typename T>
+  struct BaseGrammar :
+    StaticPolymorphic<T>
+  {
+    /// Import the static polymorphism cast
+    using StaticPolymorphic<T>::self;
+    
+    /// Matches the next token after skipping the whitespaces, removing it from the input
+    ///
+    /// Returns the symbol and the matched string, the end symbol if
+    /// the input is over, or nothing if no token can be matched
+    constexpr std::optional<std::pair<size_t,std::string_view>> nextToken(std::string_view& input) const
+    {
+      return nextToken(input,self().regexMatcher);
+    }
+    
+    /// Matches the next token with the given regex matcher
+    template <typename M>
+    constexpr std::optional<std::pair<size_t,std::string_view>> nextToken(std::string_view& input,
+									  const M& regexMatcher) const
+    {
+      if(const std::optional<RegexMatchingResult> token=regexMatcher.matchSkipping(input,self().iWhitespaceSymbol))
+	return std::make_pair(token->iToken,token->matchedString);
+      else
+	if(input.empty())
+	  return std::make_pair(self().iEndSymbol,std::string_view{});
+	else
+	  return {};
+    }
+    
+    /// Reduces the production, replacing the states and values of its rhs with those of its lhs
+    ///
+    /// Returns whether the input has been accepted, the stacks do not
+    /// contain the whole rhs, or the parse can go on
+    template <typename H>
+    constexpr GrammarParseStatus reduceProduction(const size_t& iProduction,
+						  H& handler,
+						  GrammarParseStacks<typename std::remove_cvref_t<H>::Value>& stacks) const
+    {
+      /// Type of the values associated to the symbols
+      using Value=typename std::remove_cvref_t<H>::Value;
+      
+      /// Stack of the states
+      std::vector<size_t>& states=stacks.states;
+      
+      /// Stack of the values, one for each state but the first
+      std::vector<Value>& values=stacks.values;
+      
+      /// Lhs of the production
+      const size_t iLhs=self().iLhsOfProduction(iProduction);
+      
+      if(iLhs==self().iStartSymbol)
+	return GrammarParseStatus::ACCEPT;
+      
+      /// Number of rhs symbols
+      const size_t nRhs=self().nRhsOfProduction(iProduction);
+      
+      if(nRhs>=states.size())
+	return GrammarParseStatus::UNDERFLOW;
+      
+      /// Value of the lhs
+      Value lhsValue=handler.reduce(iProduction,std::span<Value>(values.end()-nRhs,values.end()));
+      
+      states.erase(states.end()-nRhs,states.end());
+      values.erase(values.end()-nRhs,values.end());
+      
+      states.push_back(self().parseTables.gotoState(states.back(),iLhs));
+      values.push_back(std::move(lhsValue));
+      
+      return GrammarParseStatus::NEED_MORE_INPUT;
+    }
+    
+    /// Performs the default reductions of the states which do not need the lookahead
+    ///
+    /// This allows to lex the next token only when the parser actually
+    /// needs it to decide the action
+    template <typename H>
+    constexpr GrammarParseStatus reduceWithoutLookahead(H& handler,
+							GrammarParseStacks<typename std::remove_cvref_t<H>::Value>& stacks) const
+    {
+      while(not self().parseTables.needsLookahead(stacks.states.back()))
+	if(const GrammarParseStatus status=reduceProduction(self().parseTables.defaultAction(stacks.states.back()).iStateOrProduction(),handler,stacks);status!=GrammarParseStatus::NEED_MORE_INPUT)
+	  return status;
+      
+      return GrammarParseStatus::NEED_MORE_INPUT;
+    }
+    
+    /// Consumes the token, performing the reductions which it triggers and then shifting it
+    ///
+    /// Returns whether more input is needed, the input has been
+    /// accepted, leaving the value of the start symbol on top of the
+    /// values stack, or the token is not valid
+    template <typename H>
+    constexpr GrammarParseStatus consumeToken(const std::pair<size_t,std::string_view>& token,
+					      H& handler,
+					      GrammarParseStacks<typename std::remove_cvref_t<H>::Value>& stacks) const
+    {
+      /// Type of the values associated to the symbols
+      using Value=typename std::remove_cvref_t<H>::Value;
+      
+      /// Stack of the states
+      std::vector<size_t>& states=stacks.states;
+      
+      /// Stack of the values, one for each state but the first
+      std::vector<Value>& values=stacks.values;
+      
+      while(true)
+	{
+	  /// Current state
+	  const size_t& iState=states.back();
+	  
+	  /// Action to be taken
+	  const GrammarAction action=
+	    self().parseTables.needsLookahead(iState)?
+	    self().parseTables.action(iState,token.first):
+	    self().parseTables.defaultAction(iState);
+	  
+	  switch(action.type())
+	    {
+	    case GrammarAction::SHIFT:
+	      states.push_back(action.iStateOrProduction());
+	      values.push_back(handler.shift(token.first,token.second));
+	      return GrammarParseStatus::NEED_MORE_INPUT;
+	      break;
+	    case GrammarAction::REDUCE:
+	      if(const GrammarParseStatus status=reduceProduction(action.iStateOrProduction(),handler,stacks);status!=GrammarParseStatus::NEED_MORE_INPUT)
+		return status;
+	      break;
+	    case GrammarAction::ERROR:
+	      return GrammarParseStatus::ERROR;
+	      break;
+	    }
+	}
+    }
+    
+    /// Parses the input, calling the handler at each shift and reduction
+    ///
+    /// The handler must define the Value type associated to each
+    /// symbol, the shift(iSymbol,matchedString) method returning the
+    /// value of a terminal symbol, and the reduce(iProduction,rhs)
+    /// method returning the value of the lhs of the production given
+    /// those of the rhs. The value of the start symbol is returned, or
+    /// nothing if the input cannot be parsed. The reductions of the
+    /// unit productions without action are bypassed by the tables, the
+    /// value of the rhs being passed to the lhs without calling reduce
+    ///
+    /// The stacks are taken from the passed ones, which can be reused
+    /// across parses to avoid allocating at each parse
+    template <typename H>
+    constexpr std::optional<typename std::remove_cvref_t<H>::Value> parse(std::string_view input,
+									  H&& handler,
+									  GrammarParseStacks<typename std::remove_cvref_t<H>::Value>& stacks) const
+    {
+      return parseTokens([this,
+			  &input]()
+      {
+	return nextToken(input);
+      },handler,stacks);
+    }
+    
+    /// Parses the tokens returned by the lexer, calling the handler at each shift and reduction
+    ///
+    /// The lexer is called to get the next token only when the parser
+    /// needs it as lookahead, so that no token is stored in between
+    template <typename L,
+	      typename H>
+    constexpr std::optional<typename std::remove_cvref_t<H>::Value> parseTokens(L&& lexer,
+										H&& handler,
+										GrammarParseStacks<typename std::remove_cvref_t<H>::Value>& stacks) const
+    {
+      stacks.restart();
+      
+      while(true)
+	{
+	  /// Status reached after the reductions not needing the lookahead, and then after consuming the next token
+	  GrammarParseStatus status=reduceWithoutLookahead(handler,stacks);
+	  
+	  if(status==GrammarParseStatus::NEED_MORE_INPUT)
+	    {
+	      /// Next token
+	      const std::optional<std::pair<size_t,std::string_view>> token=lexer();
+	      
+	      if(not token)
+		return {};
+	      
+	      status=consumeToken(*token,handler,stacks);
+	    }
+	  
+	  switch(status)
+	    {
+	    case GrammarParseStatus::NEED_MORE_INPUT:
+	      break;
+	    case GrammarParseStatus::ACCEPT:
+	      return std::move(stacks.values.back());
+	      break;
+	    case GrammarParseStatus::ERROR:
+	    case GrammarParseStatus::UNDERFLOW:
+	      return {};
+	      break;
+	    }
+	}
+    }
+    
+    /// Parses the input, taking the structural characters from the index rather than lexing them
+    ///
+    /// The index is built first, and the lexer is only run on the text
+    /// in between the structural characters. The index and the stacks
+    /// can be reused across parses
+    template <typename H>
+    constexpr std::optional<typename std::remove_cvref_t<H>::Value> parseIndexed(const std::string_view& input,
+										 H&& handler,
+										 GrammarStructuralIndex& index,
+										 GrammarParseStacks<typename std::remove_cvref_t<H>::Value>& stacks) const
+    {
+      index.build(input,self().iStructuralSymbolOfChar,self().stringDelimiterOfChar);
+      
+      /// Position reached by the lexer
+      size_t pos=0;
+      
+      /// Next entry of the index
+      size_t iNextStructural=0;
+      
+      return parseTokens([this,
+			  &input,
+			  &index,
+			  &pos,
+			  &iNextStructural]()->std::optional<std::pair<size_t,std::string_view>>
+      {
+	while(pos<input.size())
+	  {
+	    /// Position of the next structural character
+	    const size_t next=
+	      (iNextStructural<index.positions.size())?
+	      index.positions[iNextStructural]:
+	      input.size();
+	    
+	    if(pos==next)
+	      {
+		iNextStructural++;
+		pos++;
+		
+		return std::make_pair(self().iStructuralSymbolOfChar[(unsigned char)input[next]],input.substr(next,1));
+	      }
+	    
+	    /// Text up to the next structural character
+	    std::string_view gap=input.substr(pos,next-pos);
+	    
+	    /// Token matched in the gap, or the end symbol if only whitespaces were left
+	    const std::optional<std::pair<size_t,std::string_view>> token=nextToken(gap);
+	    
+	    pos=next-gap.size();
+	    
+	    if(not token or token->first!=self().iEndSymbol)
+	      return token;
+	  }
+	
+	return std::make_pair(self().iEndSymbol,std::string_view{});
+      },handler,stacks);
+    }
+    
+    /// Parses the input taking the structural characters from a temporary index
+    template <typename H>
+    constexpr std::optional<typename std::remove_cvref_t<H>::Value> parseIndexed(const std::string_view& input,
+										 H&& handler) const
+    {
+      /// Index of the structural characters
+      GrammarStructuralIndex index;
+      
+      /// Stacks used by the parser
+      GrammarParseStacks<typename std::remove_cvref_t<H>::Value> stacks;
+      
+      return parseIndexed(input,std::forward<H>(handler),index,stacks);
+    }
+    
+    /// Parses the input lexing it with the regex matcher recognizing only the terminals valid in the current state
+    ///
+    /// The context regex matchers must have been generated first. The
+    /// next token is lexed only once the parser reached the state
+    /// needing it, so that the valid terminals are known
+    template <typename H>
+    constexpr std::optional<typename std::remove_cvref_t<H>::Value> parseContextual(std::string_view input,
+										    H&& handler,
+										    GrammarParseStacks<typename std::remove_cvref_t<H>::Value>& stacks) const
+    {
+      if(self().contextRegexMatchers.empty())
+	errorEmitter("The context regex matchers have not been generated");
+      
+      return parseTokens([this,
+			  &input,
+			  &stacks]()
+      {
+	return nextToken(input,self().contextRegexMatchers[self().iContextRegexMatcherOfState[stacks.states.back()]]);
+      },handler,stacks);
+    }
+    
+    /// Parses the input lexing it with the regex matcher of the current state, using temporary stacks
+    template <typename H>
+    constexpr std::optional<typename std::remove_cvref_t<H>::Value> parseContextual(const std::string_view& input,
+										    H&& handler) const
+    {
+      /// Stacks used by the parser
+      GrammarParseStacks<typename std::remove_cvref_t<H>::Value> stacks;
+      
+      return parseContextual(input,std::forward<H>(handler),stacks);
+    }
+    
+    /// Parses the input lexing it in the lexer modes declared by the grammar, switching mode after the terminals marked to do so
+    ///
+    /// The lexing starts in the initial mode, which uses the regex
+    /// matcher of the grammar, while the other modes use their own
+    template <typename H>
+    constexpr std::optional<typename std::remove_cvref_t<H>::Value> parseWithModes(std::string_view input,
+										   H&& handler,
+										   GrammarParseStacks<typename std::remove_cvref_t<H>::Value>& stacks) const
+    {
+      if(self().lexerModes.empty())
+	errorEmitter("No lexer mode has been declared");
+      
+      /// Current lexer mode
+      size_t iMode=0;
+      
+      return parseTokens([this,
+			  &input,
+			  &iMode]()
+      {
+	/// Current lexer mode
+	const GrammarLexerMode& mode=self().lexerModes[iMode];
+	
+	/// Next token
+	const std::optional<std::pair<size_t,std::string_view>> token=
+	  (iMode==0)?nextToken(input):nextToken(input,mode.regexMatcher);
+	
+	if(token)
+	  iMode=mode.iNextMode(token->first,iMode);
+	
+	return token;
+      },handler,stacks);
+    }
+    
+    /// Parses the input lexing it in the lexer modes declared by the grammar, using temporary stacks
+    template <typename H>
+    constexpr std::optional<typename std::remove_cvref_t<H>::Value> parseWithModes(const std::string_view& input,
+										   H&& handler) const
+    {
+      /// Stacks used by the parser
+      GrammarParseStacks<typename std::remove_cvref_t<H>::Value> stacks;
+      
+      return parseWithModes(input,std::forward<H>(handler),stacks);
+    }
+    
+    /// Parses the input, calling the handler at each shift and reduction, using temporary stacks
+    template <typename H>
+    constexpr std::optional<typename std::remove_cvref_t<H>::Value> parse(const std::string_view& input,
+									  H&& handler) const
+    {
+      /// Stacks used by the parser
+      GrammarParseStacks<typename std::remove_cvref_t<H>::Value> stacks;
+      
+      return parse(input,std::forward<H>(handler),stacks);
+    }
+    
+    /// Parses many independent inputs, storing the value of the start symbol of each of them in the outputs
+    ///
+    /// The parser stacks are reused across the inputs. When nThreads
+    /// is larger than one and the batch is not parsed at compile time,
+    /// the inputs are split in contiguous ranges among the threads,
+    /// each of which uses its own stacks and its own copy of the handler
+    template <typename H>
+    constexpr void parseBatch(const std::span<const std::string_view>& inputs,
+			      const std::span<std::optional<typename H::Value>>& outputs,
+			      const H& handler,
+			      const size_t& nThreads=1) const
+    {
+      /// Parses the inputs in the given range
+      const auto parseRange=
+	[this,
+	 &inputs,
+	 &outputs,
+	 &handler](const size_t& begin,
+		   const size_t& end)
+	{
+	  /// Handler used for the range
+	  H rangeHandler=handler;
+	  
+	  /// Stacks reused across the range
+	  GrammarParseStacks<typename H::Value> stacks;
+	  
+	  for(size_t i=begin;i<end;i++)
+	    outputs[i]=parse(inputs[i],rangeHandler,stacks);
+	};
+      
+      /// Number of inputs
+      const size_t n=inputs.size();
+      
+      if(std::is_constant_evaluated() or nThreads<2 or n<2)
+	parseRange(0,n);
+      else
+	parallelFor(nThreads,nThreads,[&parseRange,
+				       &n,
+				       &nThreads](const size_t& iThread)
+	{
+	  parseRange(iThread*n/nThreads,(iThread+1)*n/nThreads);
+	});
+    }
+    
+    /// Parses the input lexing it on a separate thread, calling the handler at each shift and reduction
+    ///
+    /// The lexer pushes the tokens into a bounded ring, from which the
+    /// parser running on the calling thread pops them, so that lexing
+    /// and parsing proceed concurrently. The handler is only called by
+    /// the calling thread, and the result is the same of parse
+    template <typename H>
+    std::optional<typename std::remove_cvref_t<H>::Value> parsePipelined(const std::string_view& input,
+									  H&& handler,
+									  GrammarParseStacks<typename std::remove_cvref_t<H>::Value>& stacks) const
+    {
+      /// Ring passing the tokens from the lexer to the parser
+      SingleProducerSingleConsumerRing<GrammarCompactToken> ring(1<<12,1<<6);
+      
+      /// Value of the start symbol
+      std::optional<typename std::remove_cvref_t<H>::Value> result;
+      
+      runConcurrently([this,
+		       &input,
+		       &ring]()
+      {
+	/// Input still to be lexed
+	std::string_view rest=input;
+	
+	for(bool over=false;not over;)
+	  {
+	    /// Next token
+	    const std::optional<std::pair<size_t,std::string_view>> token=nextToken(rest);
+	    
+	    /// Length of the matched string
+	    const size_t length=token?token->second.size():0;
+	    
+	    over=not token or token->first==self().iEndSymbol;
+	    
+	    if(not ring.push({.begin=input.size()-rest.size()-length,
+			      .length=(uint32_t)length,
+			      .iSymbol=token?(uint32_t)token->first:GrammarCompactToken::lexingError}))
+	      over=true;
+	  }
+	
+	ring.publish();
+      },[this,
+	 &input,
+	 &handler,
+	 &stacks,
+	 &ring,
+	 &result]()
+      {
+	result=parseTokens([&input,
+			    &ring]()->std::optional<std::pair<size_t,std::string_view>>
+	{
+	  /// Next token
+	  const GrammarCompactToken token=ring.pop();
+	  
+	  if(token.iSymbol==GrammarCompactToken::lexingError)
+	    return {};
+	  
+	  return std::make_pair((size_t)token.iSymbol,input.substr(token.begin,token.length));
+	},handler,stacks);
+	
+	ring.abandon();
+      });
+      
+      return result;
+    }
+    
+    /// Parses the input lexing it on a separate thread, using temporary stacks
+    template <typename H>
+    std::optional<typename std::remove_cvref_t<H>::Value> parsePipelined(const std::string_view& input,
+									  H&& handler) const
+    {
+      /// Stacks used by the parser
+      GrammarParseStacks<typename std::remove_cvref_t<H>::Value> stacks;
+      
+      return parsePipelined(input,std::forward<H>(handler),stacks);
+    }
+    
+    /// Index of the symbol with the given name
+    constexpr size_t iSymbolOfName(const std::string_view& name) const
+    {
+      /// Position of the symbol
+      const auto ref=
+	std::ranges::find_if(self().symbols,
+			     [&name](const BaseGrammarSymbol& s)
+			     {
+			       return s.name==name;
+			     });
+      
+      if(ref==self().symbols.end())
+	errorEmitter("No symbol with the given name");
+      
+      return std::distance(self().symbols.begin(),ref);
+    }
+    
+    /// Position of the end of the next occurrence of the symbol, lexing from the given position and skipping what cannot be lexed
+    constexpr size_t endOfNextSymbol(const std::string_view& input,
+				     size_t pos,
+				     const size_t& iSymbol) const
+    {
+      while(pos<input.size())
+	if(const std::optional<RegexMatchingResult> token=self().regexMatcher.match(input.substr(pos));not token or token->matchedString.empty())
+	  pos++;
+	else
+	  {
+	    pos+=token->matchedString.size();
+	    
+	    if(token->iToken==iSymbol)
+	      return pos;
+	  }
+      
+      return input.size();
+    }
+    
+    /// Parses the input from begin to at most end, speculating to start from the given state
+    ///
+    /// The parse stops before the token whose reductions would pop the
+    /// speculated state, or which would extend past the end. Returns
+    /// nothing if the input cannot be parsed from the state
+    template <typename H>
+    constexpr std::optional<GrammarParsedPiece<typename H::Value>> parsePiece(const std::string_view& input,
+									       const size_t& begin,
+									       const size_t& end,
+									       const size_t& iState,
+									       H& handler) const
+    {
+      /// Resulting piece
+      GrammarParsedPiece<typename H::Value> piece{.begin=begin,.end=begin,.stacks={}};
+      piece.stacks.states.push_back(iState);
+      
+      /// Input still to be parsed
+      std::string_view rest=input.substr(begin);
+      
+      while(piece.end<end)
+	{
+	  /// Next token
+	  const std::optional<std::pair<size_t,std::string_view>> token=nextToken(rest);
+	  
+	  if(not token)
+	    return {};
+	  
+	  /// Position where the token ends
+	  const size_t tokenEnd=input.size()-rest.size();
+	  
+	  if(tokenEnd>end)
+	    return piece;
+	  
+	  switch(consumeToken(*token,handler,piece.stacks))
+	    {
+	    case GrammarParseStatus::NEED_MORE_INPUT:
+	      piece.end=tokenEnd;
+	      break;
+	    case GrammarParseStatus::ACCEPT:
+	    case GrammarParseStatus::UNDERFLOW:
+	      return piece;
+	      break;
+	    case GrammarParseStatus::ERROR:
+	      return {};
+	      break;
+	    }
+	}
+      
+      return piece;
+    }
+    
+    /// Parses the input splitting it among the threads at the occurrences of the synchronization terminal
+    ///
+    /// The input is split in a segment per thread, each beginning
+    /// after the first occurrence of the synchronization terminal found
+    /// lexing from the nominal split point. The segments are parsed
+    /// concurrently in pieces, each beginning after an occurrence of
+    /// the terminal, speculating that the parser is in one of the
+    /// states reached shifting it, and ending when the reductions would
+    /// pop the speculated state. A serial parse then stitches the
+    /// pieces, taking over the stacks of each piece when reaching its
+    /// begin in the speculated state, and parsing by itself the rest.
+    /// The result is thus the same of the serial parse, provided that
+    /// the values returned by the handler do not depend on the order
+    /// of the calls, since copies of the handler are called
+    /// concurrently, also for the pieces which end up discarded.
+    /// Each piece is parsed from all the speculated states from which
+    /// it can be parsed, and the one in which the serial parse is
+    /// found is stitched. When none is, the serial parse falls back to
+    /// parsing by itself up to the next piece, and the fallback is
+    /// counted in nFallbacks
+    template <typename H>
+    constexpr std::optional<typename H::Value> parseParallel(const std::string_view& input,
+							     const H& handler,
+							     const std::string_view& syncSymbolName,
+							     const size_t& nThreads,
+							     size_t& nFallbacks) const
+    {
+      nFallbacks=0;
+      
+      /// Type of the values associated to the symbols
+      using Value=typename H::Value;
+      
+      /// Handler used by the serial parse
+      H mainHandler=handler;
+      
+      if(std::is_constant_evaluated() or nThreads<2)
+	return parse(input,mainHandler);
+      
+      /// Synchronization terminal
+      const size_t iSyncSymbol=iSymbolOfName(syncSymbolName);
+      
+      /// States reached shifting the synchronization terminal
+      std::vector<size_t> iSyncStates;
+      for(size_t iState=0;iState<self().parseTables.defaultActions.size();iState++)
+	if(const GrammarAction action=self().parseTables.action(iState,iSyncSymbol);action.type()==GrammarAction::SHIFT and std::ranges::find(iSyncStates,action.iStateOrProduction())==iSyncStates.end())
+	  iSyncStates.push_back(action.iStateOrProduction());
+      
+      /// Pieces parsed in each segment
+      std::vector<std::vector<GrammarParsedPiece<Value>>> segmentPieces(nThreads);
+      
+      parallelFor(nThreads,nThreads,[this,
+				     &input,
+				     &handler,
+				     &nThreads,
+				     &iSyncSymbol,
+				     &iSyncStates,
+				     &segmentPieces](const size_t& iSegment)
+      {
+	/// Returns the begin of the segment
+	const auto segmentBegin=
+	  [this,
+	   &input,
+	   &nThreads,
+	   &iSyncSymbol](const size_t& iSegment)
+	  {
+	    if(iSegment==0)
+	      return (size_t)0;
+	    else
+	      if(iSegment==nThreads)
+		return input.size();
+	      else
+		return endOfNextSymbol(input,iSegment*input.size()/nThreads,iSyncSymbol);
+	  };
+	
+	/// End of the segment
+	const size_t end=segmentBegin(iSegment+1);
+	
+	/// Handler used for the segment
+	H segmentHandler=handler;
+	
+	/// Initial state of the parser
+	const std::array<size_t,1> iInitialStates{0};
+	
+	for(size_t begin=segmentBegin(iSegment);begin<end;)
+	  {
+	    /// Position where the parse of the piece stopped
+	    size_t stop=begin;
+	    
+	    /// States from which the piece can be parsed
+	    const std::span<const size_t> iStates=
+	      (begin==0)?std::span<const size_t>(iInitialStates):std::span<const size_t>(iSyncStates);
+	    
+	    for(const size_t& iState : iStates)
+	      if(std::optional<GrammarParsedPiece<Value>> piece=parsePiece(input,begin,end,iState,segmentHandler);piece and piece->end>begin)
+		{
+		  stop=(stop==begin)?piece->end:std::min(stop,piece->end);
+		  segmentPieces[iSegment].push_back(std::move(*piece));
+		}
+	    
+	    begin=endOfNextSymbol(input,stop,iSyncSymbol);
+	  }
+      });
+      
+      GrammarParseStacks<Value> stacks;
+      stacks.restart();
+      
+      /// Input still to be parsed
+      std::string_view rest=input;
+      
+      /// Segment and piece to be possibly stitched next
+      size_t iSegment=0,iPiece=0;
+      
+      while(true)
+	{
+	  /// Position reached so far
+	  const size_t pos=input.size()-rest.size();
+	  
+	  while(iSegment<nThreads and (iPiece==segmentPieces[iSegment].size() or segmentPieces[iSegment][iPiece].begin<pos))
+	    if(iPiece<segmentPieces[iSegment].size())
+	      iPiece++;
+	    else
+	      {
+		iSegment++;
+		iPiece=0;
+	      }
+	  
+	  if(iSegment<nThreads and segmentPieces[iSegment][iPiece].begin==pos)
+	    {
+	      /// Pieces speculated to begin at the position
+	      std::span<GrammarParsedPiece<Value>> candidates(segmentPieces[iSegment].begin()+iPiece,segmentPieces[iSegment].end());
+	      candidates=candidates.first(std::ranges::find_if(candidates,
+							       [&pos](const GrammarParsedPiece<Value>& piece)
+							       {
+								 return piece.begin!=pos;
+							       })-candidates.begin());
+	      
+	      if(const auto piece=
+		 std::ranges::find_if(candidates,
+				      [&stacks](const GrammarParsedPiece<Value>& piece)
+				      {
+					return piece.stacks.states.front()==stacks.states.back();
+				      });piece!=candidates.end())
+		{
+		  stacks.states.insert(stacks.states.end(),piece->stacks.states.begin()+1,piece->stacks.states.end());
+		  stacks.values.insert(stacks.values.end(),std::make_move_iterator(piece->stacks.values.begin()),std::make_move_iterator(piece->stacks.values.end()));
+		  rest=input.substr(piece->end);
+		  iPiece+=candidates.size();
+		  
+		  continue;
+		}
+	      else
+		nFallbacks++;
+	    }
+	  
+	  /// Next token
+	  const std::optional<std::pair<size_t,std::string_view>> token=nextToken(rest);
+	  
+	  if(not token)
+	    return {};
+	  
+	  switch(consumeToken(*token,mainHandler,stacks))
+	    {
+	    case GrammarParseStatus::NEED_MORE_INPUT:
+	      break;
+	    case GrammarParseStatus::ACCEPT:
+	      return std::move(stacks.values.back());
+	      break;
+	    case GrammarParseStatus::ERROR:
+	    case GrammarParseStatus::UNDERFLOW:
+	      return {};
+	      break;
+	    }
+	}
+    }
+    
+    /// Parses the input splitting it among the threads at the occurrences of the synchronization terminal, discarding the count of fallbacks
+    template <typename H>
+    constexpr std::optional<typename H::Value> parseParallel(const std::string_view& input,
+							     const H& handler,
+							     const std::string_view& syncSymbolName,
+							     const size_t& nThreads) const
+    {
+      /// Number of pieces which could not be stitched
+      size_t nFallbacks;
+      
+      return parseParallel(input,handler,syncSymbolName,nThreads,nFallbacks);
+    }
+    
+    /// Creates a parser to be fed with the input one chunk at a time, calling the handler at each shift and reduction
+    template <typename H>
+    constexpr GrammarPushParser<T,std::remove_cvref_t<H>> pushParser(H&& handler) const
+    {
+      return {self(),std::forward<H>(handler)};
+    }
+    
+    /// Parses the input read asynchronously from the source, yielding the parse events
+    ///
+    /// The source must provide a next() method returning an awaitable,
+    /// which results in the next chunk of input, or in an empty chunk
+    /// when the input is over. Each chunk is parsed as a whole, and its
+    /// events are yielded before awaiting the next one, the last event
+    /// reporting whether the input has been accepted. The matched
+    /// strings are valid until the next event is requested. The grammar
+    /// and the source must outlive the generator
+    template <typename S>
+    GrammarEventGenerator parseAsync(S& source) const
+    {
+      /// Parser of the chunks
+      GrammarPushParser<T,GrammarEventRecorder> parser(self(),{});
+      
+      /// Events of each chunk
+      GrammarEventRecorder& recorder=parser.handler;
+      
+      while(parser.status==GrammarParseStatus::NEED_MORE_INPUT)
+	{
+	  /// Next chunk of input
+	  const std::string_view chunk=co_await source.next();
+	  
+	  recorder.chunk=chunk;
+	  
+	  if(chunk.empty())
+	    parser.finish();
+	  else
+	    parser.push(chunk);
+	  
+	  for(const GrammarParseEvent& event : recorder.events)
+	    co_yield event;
+	  
+	  recorder.events.clear();
+	}
+      
+      co_yield GrammarParseEvent{(parser.status==GrammarParseStatus::ACCEPT)?GrammarParseEvent::ACCEPT:GrammarParseEvent::ERROR,0,{}};
+    }
+    
+    /// Parses the input forwarding the shifts and reductions to the listener, returning whether the input has been parsed
+    template <typename L>
+    constexpr bool parseEvents(const std::string_view& input,
+			       L&& listener) const
+    {
+      return parse(input,GrammarEventsForwarder<std::remove_reference_t<L>>{listener}).has_value();
+    }
+    
+    /// Parses the input into the concrete syntax tree, returning the index of the root node, or nothing if the input cannot be parsed
+    ///
+    /// The tree is cleared before parsing, keeping its storage. The
+    /// chains of unit productions without action are collapsed, since
+    /// the parse tables bypass their reductions: given the production
+    /// "value: integer" without action, the node of the integer takes
+    /// the place of the node of the value, which is never created
+    constexpr std::optional<size_t> parseTree(const std::string_view& input,
+					      GrammarTree& tree) const
+    {
+      tree.clear();
+      
+      return parse(input,GrammarTreeBuilder<T>{self(),tree},tree.stacks);
+    }
+    
+    /// Determines whether the input is recognized by the grammar
+    constexpr bool recognizes(const std::string_view& input) const
+    {
+      return parse(input,GrammarRecognizer{}).has_value();
+    }
+  };
+  
+  /// Grammar with all the functions to create it
+  struct Grammar :
+    BaseGrammar<Grammar>
+  {
+    std::string_view name;
+    
+    std::vector<GrammarSymbol> symbols;
+    
+    size_t iStartSymbol{};
+    
+    size_t iEndSymbol{};
+    
+    size_t iErrorSymbol{};
+    
+    size_t iWhitespaceSymbol{};
+    
+    size_t currentPrecedence{};
+    
+    std::vector<GrammarProduction> productions;
+    
+    std::vector<std::string_view> whitespaceRegexList;
+    
+    /// Lexer modes, the first being the initial one, if any has been declared
+    std::vector<GrammarLexerMode> lexerModes;
+    
+    std::vector<GrammarItem> items;
+    
+    /// Hash index of the items, to intern them by production and position
+    HashedUniqueVectorIndex itemsIndex;
+    
+    std::vector<GrammarState> stateItems;
+    
+    /// Hash index of the states, to intern them by their sorted items
+    HashedUniqueVectorIndex stateItemsIndex;
+    
+    std::vector<std::vector<GrammarTransition>> stateTransitions;
+    
+    /// Transitions over non-terminal symbols, grouped by state and sorted by symbol
+    std::vector<GrammarNonTerminalTransition> nonTerminalTransitions;
+    
+    /// First non-terminal transition of each state, plus the total number of non-terminal transitions
+    std::vector<size_t> iFirstNonTerminalTransitionOfState;
+    
+    /// Reductions to be performed in each state
+    std::vector<std::vector<GrammarReduction>> stateReductions;
+    
+    /// Reduction to be performed in each state when no other action is defined for the lookahead
+    std::vector<std::optional<size_t>> iDefaultReductionOfState;
+    
+    RegexMatcher regexMatcher;
+    
+    /// Symbol of each structural character
+    StructuralSymbolOfChar iStructuralSymbolOfChar;
+    
+    /// Kind of string delimited by each character
+    StringDelimiterOfChar stringDelimiterOfChar;
+    
+    std::vector<size_t> iSymbolOfRegex;
+    
+    /// Regex matchers recognizing only the terminals valid in some states, when generated
+    std::vector<RegexMatcher> contextRegexMatchers;
+    
+    /// Context regex matcher used in each state
+    std::vector<size_t> iContextRegexMatcherOfState;
+    
+    /// Compressed tables of actions and goto states
+    GrammarParseTables parseTables;
+    
+    /// Number of threads used to build the grammar, when not evaluated at compile time
+    size_t nThreads{1};
+    
+    /// Calls f on all indices up to n, concurrently if allowed
+    template <typename F>
+    constexpr void forEachIndex(const size_t& n,
+				const F& f) const
+    {
+      if(std::is_constant_evaluated() or nThreads<2 or n<2)
+	for(size_t i=0;i<n;i++)
+	  f(i);
+      else
+	parallelFor(nThreads,n,f);
+    }
+    
+    /// Describes a production
+    constexpr inline std::string describe(const GrammarProduction& production) const
+    {
+      return production.describe(symbols);
+    }
+    
+    /// Describes an item
+    constexpr inline std::string describe(const GrammarItem& item) const
+    {
+      return item.describe(productions,symbols);
+    }
+    
+    /// Describes the state
+    constexpr inline std::string describe(const GrammarState& state,
+					  const std::string& pref="") const
+    {
+      return state.describe(items,productions,symbols,pref);
+    }
+    
+    /// Describes a transition
+    constexpr inline std::string describe(const GrammarTransition& transition) const
+    {
+      return transition.describe(items,productions,symbols,stateItems);
+    }
+    
+    /// Finds or insert a symbol
+    constexpr size_t insertOrFindSymbol(const std::string_view& name,
+					const GrammarSymbol::Type& type)
+    {
+      GrammarSymbol* s;
+      
+      if(auto ref=
+	 std::ranges::find_if(symbols,
+			      [&name,
+			       &type](const GrammarSymbol& s)
+			      {
+				return s.name==name and s.type==type;
+			      });ref!=symbols.end())
+	s=&(*ref);
+      else
+	s=&symbols.emplace_back(name,type);
+      
+      return std::distance(symbols.begin(),(std::vector<GrammarSymbol>::iterator)s);
+    }
+    
+    constexpr std::optional<size_t> matchAndParseSymbol(StringMatcher& m)
+    {
+      m.matchWhiteSpaceOrComments();
+      
+      if(m.matchStr("error"))
+	return iErrorSymbol;
+      else if(auto l=m.matchLiteral();not l.empty())
+	return insertOrFindSymbol(l,GrammarSymbol::Type::TERMINAL_SYMBOL);
+      else if(auto r=m.matchRegex();not r.empty())
+	return insertOrFindSymbol(r,GrammarSymbol::Type::TERMINAL_SYMBOL);
+      else if(auto i=m.matchId();not i.empty())
+	return insertOrFindSymbol(i,GrammarSymbol::Type::NON_TERMINAL_SYMBOL);
+      
+      return std::nullopt;
+    }
+    
+    constexpr bool matchAndParseAssociativityStatement(StringMatcher& matchin)
+    {
+      /// Undo if not matching
+      auto matchRes=
+	matchin.beginTemptativeMatch("associativityStatement",false);
+      
+      using enum GrammarSymbol::Associativity;
+      
+      constexpr std::array<std::pair<std::string_view,GrammarSymbol::Associativity>,3>
+		  possibleAssociativities{std::make_pair("%none",NONE),
+					  std::make_pair("%left",LEFT),
+					  std::make_pair("%right",RIGHT)};
+      
+      matchin.matchWhiteSpaceOrComments();
+      
+      size_t iAss=0;
+      while(iAss<possibleAssociativities.size() and
+	    not matchin.matchStr(possibleAssociativities[iAss].first))
+	iAss++;
+      
+      if(iAss!=possibleAssociativities.size())
+	{
+	  diagnostic("Matched ",possibleAssociativities[iAss].first.begin()," associativity\n");
+	  
+	  GrammarSymbol::Associativity currentAssociativity=possibleAssociativities[iAss].second;
+	  currentPrecedence++;
+	  
+	  while(auto m=matchAndParseSymbol(matchin))
+	    {
+	      GrammarSymbol& s=symbols[*m];
+	      diagnostic("Matched symbol: \"",name,"\"\n");
+	      
+	      s.associativity=currentAssociativity;
+	      s.precedence=currentPrecedence;
+	    }
+	  
+	  matchin.matchWhiteSpaceOrComments();
+	  
+	  if((matchRes.state=matchin.matchChar(';')))
+	    diagnostic("Matched associativity statement end\n");
+	  else
+	    errorEmitter("Unterminated associativity statement");
+	}
+      
+      return matchRes;
+    }
+    
+    constexpr bool matchAndParseProductionStatement(StringMatcher& matchin)
+    {
+      auto matchRes=
+	matchin.beginTemptativeMatch("productionStatement",false);
+      
+      matchin.matchWhiteSpaceOrComments();
+      
+      if(auto i=matchin.matchId();not i.empty())
+	{
+	  auto iLhs=
+	    insertOrFindSymbol(i,GrammarSymbol::Type::NON_TERMINAL_SYMBOL);
+	  diagnostic("Found lhs: ",symbols[iLhs].name,"\n");
+	  
+	  // Add the first symbol found as a starting reduction
+	  if(productions.empty())
+	    {
+	      // Add the rule as a starting rule
+	      productions.emplace_back(iStartSymbol,std::vector<size_t>{iLhs});
+	      symbols[iStartSymbol].iProductions.emplace_back(0);
+	    }
+	  
+	  matchin.matchWhiteSpaceOrComments();
+	  if(matchin.matchChar(':'))
+	    {
+	      do
+		{
+		  /// Right hand side of the production
+		  std::vector<size_t> iRhss;
+		  matchin.matchWhiteSpaceOrComments();
+		  while(std::optional<size_t> iMatchedSymbol=matchAndParseSymbol(matchin))
+		    {
+		      iRhss.push_back(*iMatchedSymbol);
+		      matchin.matchWhiteSpaceOrComments();
+		      diagnostic("Found rhs: ",symbols[*iMatchedSymbol].name,"\n");
+		    }
+		  
+		  std::optional<size_t> iPrecedenceSymbol;
+		  if(matchin.matchStr("%precedence"))
+		    {
+		      if((iPrecedenceSymbol=matchAndParseSymbol(matchin)))
+			symbols[*iPrecedenceSymbol].referredAsPrecedenceSymbol=true;
+		      else
+			errorEmitter("Expected symbol from which to infer the precedence");
+		      
+		      matchin.matchWhiteSpaceOrComments();
+		    }
+		  
+		  std::string_view action{};
+		  if(matchin.matchChar('['))
+		    {
+		      matchin.matchWhiteSpaceOrComments();
+		      
+		      if(action=matchin.matchId();action.empty())
+			errorEmitter("Expected identifier to be used as action");
+		      
+		      diagnostic("matched action: \"",action,"\"\n");
+		      
+		      matchin.matchWhiteSpaceOrComments();
+		      if(not matchin.matchChar(']'))
+			errorEmitter("Expected end of action ']'");
+		      
+		      matchin.matchWhiteSpaceOrComments();
+		    }
+		  
+		  symbols[iLhs].iProductions.push_back(productions.size());
+		  productions.emplace_back(iLhs,iRhss,iPrecedenceSymbol,action);
+		  
+		  diagnostic("ADDED production ",describe(productions.back()),"\n");
+		}
+	      while(matchin.matchChar('|'));
+	      
+	      if((matchRes.state=matchin.matchChar(';')))
+		diagnostic("Found production statement end\n");
+	    }
+	}
+      
+      return matchRes;
+    }
+    
+    constexpr bool matchAndParseWhitespaceStatement(StringMatcher& matchin)
+    {
+      /// Undo if not matching
+      auto matchRes=
+	matchin.beginTemptativeMatch("whitespace statement",false);
+      
+      matchin.matchWhiteSpaceOrComments();
+      
+      if(matchin.matchStr("%whitespace"))
+	{
+	  diagnostic("Matched whitespace statement\n");
+	  
+	  matchin.matchWhiteSpaceOrComments();
+	  
+	  bool goon=true;;
+	  while(goon)
+	    {
+	      auto l=matchin.matchRegex();
+	      if(not l.empty())
+		{
+		  whitespaceRegexList.emplace_back(l);
+		  diagnostic("Matched regex ",l,"\n");
+		  matchin.matchWhiteSpaceOrComments();
+		}
+	      else goon=false;
+	    }
+	  
+	  matchRes.state=matchin.matchChar(';');
+	}
+      
+      return matchRes;
+    }
+    
+    /// Finds or inserts a lexer mode, inserting first the initial one
+    constexpr size_t insertOrFindLexerMode(const std::string_view& name)
+    {
+      if(lexerModes.empty())
+	lexerModes.push_back({.name="initial",.isDeclared=true,.iTerminalsAndNextModes={},.regexMatcher={}});
+      
+      /// Mode with the given name
+      const auto ref=std::ranges::find(lexerModes,name,&GrammarLexerMode::name);
+      
+      if(ref!=lexerModes.end())
+	return std::distance(lexerModes.begin(),ref);
+      
+      lexerModes.push_back({.name=name,.isDeclared=false,.iTerminalsAndNextModes={},.regexMatcher={}});
+      
+      return lexerModes.size()-1;
+    }
+    
+    /// Matches a lexer mode statement, listing the terminals of the mode and the modes entered after them
+    ///
+    /// The syntax is %mode name { terminal [-> next] ... }, where the
+    /// terminals can also be given by the name of their alias. The
+    /// terminals not listed in any mode belong to the initial one,
+    /// which is the only one skipping the whitespaces. To leave the
+    /// initial mode after a terminal, the latter must be listed in a
+    /// statement %mode initial { terminal -> next }. Entering a mode
+    /// which is never declared is an error
+    constexpr bool matchAndParseLexerModeStatement(StringMatcher& matchin)
+    {
+      /// Undo if not matching
+      auto matchRes=
+	matchin.beginTemptativeMatch("lexer mode statement",false);
+      
       matchin.matchWhiteSpaceOrComments();
       
-      if(auto i=matchin.matchId();not i.empty())
+      if(matchin.matchStr("%mode"))
+	{
+	  matchin.matchWhiteSpaceOrComments();
+	  
+	  /// Name of the mode
+	  const std::string_view modeName=matchin.matchId();
+	  if(modeName.empty())
+	    errorEmitter("Expected the name of the lexer mode");
+	  
+	  diagnostic("Matched lexer mode ",modeName,"\n");
+	  
+	  /// Index of the mode
+	  const size_t iMode=insertOrFindLexerMode(modeName);
+	  lexerModes[iMode].isDeclared=true;
+	  
+	  matchin.matchWhiteSpaceOrComments();
+	  if(not matchin.matchChar('{'))
+	    errorEmitter("Expected the beginning of the lexer mode '{'");
+	  
+	  while(std::optional<size_t> iSymbol=matchAndParseSymbol(matchin))
+	    {
+	      /// Mode entered after matching the terminal
+	      size_t iNextMode=iMode;
+	      
+	      matchin.matchWhiteSpaceOrComments();
+	      if(matchin.matchStr("->"))
+		{
+		  matchin.matchWhiteSpaceOrComments();
+		  
+		  /// Name of the mode entered
+		  const std::string_view nextModeName=matchin.matchId();
+		  if(nextModeName.empty())
+		    errorEmitter("Expected the name of the lexer mode to be entered");
+		  
+		  iNextMode=insertOrFindLexerMode(nextModeName);
+		}
+	      
+	      lexerModes[iMode].iTerminalsAndNextModes.emplace_back(*iSymbol,iNextMode);
+	      diagnostic("Matched terminal ",symbols[*iSymbol].name," entering lexer mode ",lexerModes[iNextMode].name,"\n");
+	    }
+	  
+	  matchin.matchWhiteSpaceOrComments();
+	  if(not (matchRes.state=matchin.matchChar('}')))
+	    errorEmitter("Expected the end of the lexer mode '}'");
+	}
+      
+      return matchRes;
+    }
+    
+    /// Adds generic symbols to the symbols list
+    constexpr void addGenericSymbols()
+    {
+      using enum GrammarSymbol::Type;
+      
+      for(const auto& [name,type,i] :
+	    {std::make_tuple(".start",NON_TERMINAL_SYMBOL,&iStartSymbol),
+	     {".end",END_SYMBOL,&iEndSymbol},
+	     {".error",NULL_SYMBOL,&iErrorSymbol},
+	     {".whitespace",NULL_SYMBOL,&iWhitespaceSymbol}})
+	{
+	  *i=symbols.size();
+	  symbols.emplace_back(name,type);
+	}
+    }
+    
+    /// Matches the passed string into symbols, actions, productions, etc
+    constexpr void parseTheGrammar(const std::string_view& str)
+    {
+      /// Embeds the string into a matcher
+      StringMatcher match(str);
+      
+      match.matchWhiteSpaceOrComments();
+      
+      if(auto id=match.matchId();not id.empty())
+	{
+	  name=id;
+	  
+	  diagnostic("Matched grammar: \"",id,"\", skipped to ",match.ref.begin(),"\n");
+	  
+	  match.matchWhiteSpaceOrComments();
+	  
+	  if(match.matchChar('{'))
+	    {
+	      diagnostic("Matched {\n");
+	      
+	      while(matchAndParseAssociativityStatement(match) or
+		    matchAndParseWhitespaceStatement(match) or
+		    matchAndParseLexerModeStatement(match) or
+		    matchAndParseProductionStatement(match))
+		diagnostic("parsed some statement\n");
+	      
+	      match.matchWhiteSpaceOrComments();
+	      if(not match.matchChar('}'))
+		diagnostic("Unfinished grammar, reference is: \"",match.ref,"\"\n");
+	      
+	      match.matchWhiteSpaceOrComments();
+	      if(not match.ref.empty())
+		errorEmitter("Unfinished parsing!\n");
+	      else
+		diagnostic("Grammar parsing correctly ended\n");
+	    }
+	  else
+	    errorEmitter("Empty grammar\n");
+	}
+      else
+	errorEmitter("Unmatched id to name the grammar\n");
+    }
+    
+    /// Performs some test of the grammar
+    constexpr void checkTheGrammar()
+    {
+      // Check that all symbols are referenced at least once and defined
+      for(const GrammarSymbol& s : symbols)
+	if(s.type==GrammarSymbol::Type::NON_TERMINAL_SYMBOL and s.iProductions.empty() and not s.referredAsPrecedenceSymbol)
+	  errorEmitter("Undefined symbol");
+      
+      for(const GrammarLexerMode& mode : lexerModes)
+	if(not mode.isDeclared)
+	  errorEmitter((std::string("Lexer mode ")+std::string(mode.name)+" is entered but never declared").c_str());
+      
+      /// Count of symbols usage as rhs or precedence
+      std::vector<size_t> symbolsCount(symbols.size(),0);
+      for(const GrammarProduction& production : productions)
+	{
+	  for(const size_t& r : production.iRhsList)
+	    symbolsCount[r]++;
+	  
+	  if(auto p=production.precedenceSymbol)
+	    symbolsCount[*p]++;
+	}
+      
+      // Check that the symbols are used
+      for(size_t iSymbol=0;iSymbol<symbols.size();iSymbol++)
+	if(const std::array<size_t,4> filt{iStartSymbol,iEndSymbol,iErrorSymbol,iWhitespaceSymbol};
+	   std::find(filt.begin(),filt.end(),iSymbol)==filt.end())
+	  if(symbolsCount[iSymbol]==0)
+	    {
+	      diagnostic("Symbol ",symbols[iSymbol].name," ",iSymbol," ",iStartSymbol,"\n");
+	      errorEmitter("Unreferenced symbol");
+	    }
+    }
+    
+    /// Remove the references to a symbol
+    constexpr void replaceSymbolReference(size_t& iTargetSymbol,
+					  const size_t& iReplacedSymbol,
+					  const size_t& iReplacementSymbol)
+    {
+      // const size_t old=target;
+      
+      if(iTargetSymbol==iReplacedSymbol)
+	iTargetSymbol=iReplacementSymbol;
+      
+      if(iTargetSymbol>iReplacedSymbol)
+	iTargetSymbol--;
+      
+      // if(old!=target)
+      //   diagnostic("before was ",old,"now is ",target,"\n");
+    }
+    
+    /// Replaces all occurrence of the first symbol with that of the second, and remove it from the list
+    constexpr void replaceAndRemoveSymbol(const size_t& iReplacedSymbol,
+					  const size_t& iReplacementSymbol)
+    {
+      /// Checks that noth both symbols declared "what"
+      const auto checkNotBothDeclared=
+	[this,
+	 iReplacedSymbol,
+	 iReplacementSymbol](const size_t& replaced,
+			     const size_t& replacement,
+			     const char* what)
+	{
+	  if(replaced!=0 and replacement!=0)
+	    errorEmitter((std::string("symbol ")+std::string(symbols[iReplacedSymbol].name)+std::string(" to be replaced by ")+std::string(symbols[iReplacementSymbol].name)+std::string(" but both have a declared ")+what).c_str());
+	};
+      
+      const size_t& replacedPrecedence=symbols[iReplacedSymbol].precedence;
+      size_t& replacementPrecedence=symbols[iReplacementSymbol].precedence;
+      
+      checkNotBothDeclared(replacedPrecedence,replacementPrecedence,"precedence");
+      
+      if(replacedPrecedence!=0 and replacementPrecedence!=0)
+	errorEmitter((std::string("symbol ")+std::string(symbols[iReplacedSymbol].name)+std::string(" to be replaced by ")+std::string(symbols[iReplacementSymbol].name)+std::string(" but both have a declared precedence")).c_str());
+      
+      if(replacedPrecedence)
+	replacementPrecedence=replacedPrecedence;
+      
+      const GrammarSymbol::Associativity& replacedAssociativity=symbols[iReplacedSymbol].associativity;
+      GrammarSymbol::Associativity& replacementAssociativity=symbols[iReplacementSymbol].associativity;
+      
+      checkNotBothDeclared((size_t)replacedAssociativity,(size_t)replacementAssociativity,"associativity");
+      
+      if(replacedAssociativity!=GrammarSymbol::Associativity::NONE)
+	replacementAssociativity=replacedAssociativity;
+      
+      /// Incapsulate the replacement of the symbol
+      const auto action=
+	[this,
+	 iReplacedSymbol,
+	 iReplacementSymbol](size_t& i)
+	{
+	  replaceSymbolReference(i,iReplacedSymbol,iReplacementSymbol);
+	};
+      
+      for(GrammarProduction& p : productions)
 	{
-	  auto iLhs=
-	    insertOrFindSymbol(i,GrammarSymbol::Type::NON_TERMINAL_SYMBOL);
-	  diagnostic("Found lhs: ",symbols[iLhs].name,"\n");
+	  action(p.iLhs);
 	  
-	  // Add the first symbol found as a starting reduction
-	  if(productions.empty())
-	    {
-	      // Add the rule as a starting rule
-	      productions.emplace_back(iStartSymbol,std::vector<size_t>{iLhs});
-	      symbols[iStartSymbol].iProductions.emplace_back(0);
-	    }
+	  for(size_t& iRhs : p.iRhsList)
+	    action(iRhs);
 	  
-	  matchin.matchWhiteSpaceOrComments();
-	  if(matchin.matchChar(':'))
-	    {
-	      do
-		{
-		  /// Right hand side of the production
-		  std::vector<size_t> iRhss;
-		  matchin.matchWhiteSpaceOrComments();
-		  while(std::optional<size_t> iMatchedSymbol=matchAndParseSymbol(matchin))
-		    {
-		      iRhss.push_back(*iMatchedSymbol);
-		      matchin.matchWhiteSpaceOrComments();
-		      diagnostic("Found rhs: ",symbols[*iMatchedSymbol].name,"\n");
-		    }
-		  
-		  std::optional<size_t> iPrecedenceSymbol;
-		  if(matchin.matchStr("%precedence"))
-		    {
-		      if((iPrecedenceSymbol=matchAndParseSymbol(matchin)))
-			symbols[*iPrecedenceSymbol].referredAsPrecedenceSymbol=true;
-		      else
-			errorEmitter("Expected symbol from which to infer the precedence");
-		      
-		      matchin.matchWhiteSpaceOrComments();
-		    }
-		  
-		  std::string_view action{};
-		  if(matchin.matchChar('['))
+	  if(p.precedenceSymbol)
+	    action(*p.precedenceSymbol);
+	}
+      
+      for(GrammarLexerMode& mode : lexerModes)
+	for(auto& [iSymbol,iNextMode] : mode.iTerminalsAndNextModes)
+	  action(iSymbol);
+      
+      symbols.erase(symbols.begin()+iReplacedSymbol);
+    }
+    
+    /// Removes the given production
+    constexpr void removeProduction(const size_t& iProduction)
+    {
+      diagnostic("Removing production: ",describe(productions[iProduction]),"\n");
+      
+      // Remove production from the list
+      productions.erase(productions.begin()+iProduction);
+      
+      // Update the production references
+      for(GrammarSymbol& s : symbols)
+	for(size_t& jProduction : s.iProductions)
+	  if(jProduction>iProduction)
+	    jProduction--;
+    }
+    
+    /// Replaces a non-terminal symbols that is actually named terminals
+    constexpr bool removeOneRedundantProductionIfFound()
+    {
+      bool removed=false;
+      
+      size_t iSymbol=0;
+      while(iSymbol<symbols.size() and not removed)
+	{
+	  if(iSymbol!=iErrorSymbol)
+	    if(GrammarSymbol& symbol=symbols[iSymbol];symbol.iProductions.size()==1)
+	      {
+		const size_t /* don't take by reference! */iProduction=symbol.iProductions.front();
+		
+		if(const GrammarProduction& production=productions[iProduction];production.iRhsList.size()==1 and production.action.empty())
+		  if(const size_t /* don't take by reference! */ iActualSymbol=production.iRhsList.front();symbols[iActualSymbol].type==GrammarSymbol::Type::TERMINAL_SYMBOL)
 		    {
-		      matchin.matchWhiteSpaceOrComments();
-		      
-		      if(action=matchin.matchId();action.empty())
-			errorEmitter("Expected identifier to be used as action");
-		      
-		      diagnostic("matched action: \"",action,"\"\n");
-		      
-		      matchin.matchWhiteSpaceOrComments();
-		      if(not matchin.matchChar(']'))
-			errorEmitter("Expected end of action ']'");
+		      removed=true;
+		      diagnostic("Symbol \"",symbol.name,"\" with precedence ",symbol.precedence,
+				 " is an alias for the terminal: \"",symbols[iActualSymbol].name,"\" with precedence ",symbols[iActualSymbol].precedence,"\n");
 		      
-		      matchin.matchWhiteSpaceOrComments();
+		      removeProduction(iProduction);
+		      replaceAndRemoveSymbol(iSymbol,iActualSymbol);
 		    }
-		  
-		  symbols[iLhs].iProductions.push_back(productions.size());
-		  productions.emplace_back(iLhs,iRhss,iPrecedenceSymbol,action);
-		  
-		  diagnostic("ADDED production ",describe(productions.back()),"\n");
-		}
-	      while(matchin.matchChar('|'));
+	      }
+	  
+	  if(not removed)
+	    iSymbol++;
+	}
+      
+      return removed;
+    }
+    
+    /// Checks that the lexer modes only list terminals, each once
+    ///
+    /// Carried out after the optimization, which replaces the aliases
+    /// of the terminals with the terminals themselves
+    constexpr void checkTheLexerModes() const
+    {
+      for(const GrammarLexerMode& mode : lexerModes)
+	for(size_t i=0;i<mode.iTerminalsAndNextModes.size();i++)
+	  {
+	    /// Symbol listed in the mode
+	    const size_t& iSymbol=mode.iTerminalsAndNextModes[i].first;
+	    
+	    if(symbols[iSymbol].type!=GrammarSymbol::Type::TERMINAL_SYMBOL)
+	      errorEmitter((std::string("Only terminals can be listed in a lexer mode, but ")+std::string(symbols[iSymbol].name)+" is listed in "+std::string(mode.name)).c_str());
+	    
+	    for(size_t j=0;j<i;j++)
+	      if(mode.iTerminalsAndNextModes[j].first==iSymbol)
+		errorEmitter((std::string("Terminal ")+std::string(symbols[iSymbol].name)+" listed twice in the lexer mode "+std::string(mode.name)).c_str());
+	  }
+    }
+    
+    /// Performs grammar optimization
+    constexpr void grammarOptimize()
+    {
+      const auto diag=
+	[this](const char* tag)
+	{
+	  diagnostic("-----------------------------------\n");
+	  diagnostic("list of productions ",tag," optimization:\n");
+	  for(const GrammarProduction& production : productions)
+	    diagnostic(describe(production),"\n");
+	  diagnostic("list of symbols ",tag," optimization:\n");
+	  for(const GrammarSymbol& s : symbols)
+	    diagnostic("symbol ",s.name,"\n");
+	  diagnostic("\n");
+	  diagnostic("-----------------------------------\n");
+	};
+      
+      diag("before");
+      
+      bool doneSomething;
+      do
+	{
+	  doneSomething=false;
+	  doneSomething|=removeOneRedundantProductionIfFound();
+	}
+      while(doneSomething);
+      
+      diag("after");
+    }
+    
+    /// Computes whether the symbols are nullable, propagating the nullability along the productions
+    constexpr void calculateNullables()
+    {
+      diagnostic("-----------------------------------\n");
+      
+      /// Number of rhs symbols not yet known to be nullable, for each production
+      std::vector<size_t> nNonNullableRhs(productions.size());
+      
+      /// Productions containing each symbol in the rhs, repeated for each occurrence
+      std::vector<std::vector<size_t>> iProductionsContaining(symbols.size());
+      
+      /// Symbols found to be nullable, whose nullability is still to be propagated
+      std::vector<size_t> iNullableSymbolsToPropagate;
+      
+      /// Marks the symbol as nullable, if not already marked
+      const auto markNullable=
+	[this,
+	 &iNullableSymbolsToPropagate](const size_t& iSymbol)
+	{
+	  if(GrammarSymbol& s=symbols[iSymbol];not s.nullable)
+	    {
+	      diagnostic("Symbol ",s.name," is nullable\n");
+	      s.nullable=true;
+	      iNullableSymbolsToPropagate.push_back(iSymbol);
+	    }
+	};
+      
+      for(size_t iP=0;iP<productions.size();iP++)
+	{
+	  const GrammarProduction& p=productions[iP];
+	  
+	  nNonNullableRhs[iP]=p.iRhsList.size();
+	  for(const size_t& iRhs : p.iRhsList)
+	    iProductionsContaining[iRhs].push_back(iP);
+	  
+	  if(p.iRhsList.empty())
+	    markNullable(p.iLhs);
+	}
+      
+      while(not iNullableSymbolsToPropagate.empty())
+	{
+	  const size_t iSymbol=iNullableSymbolsToPropagate.back();
+	  iNullableSymbolsToPropagate.pop_back();
+	  
+	  for(const size_t& iP : iProductionsContaining[iSymbol])
+	    if(--nNonNullableRhs[iP]==0)
+	      markNullable(productions[iP].iLhs);
+	}
+    }
+    
+    /// Lists the elements of a set of symbols
+    constexpr std::vector<size_t> listSymbols(const BitSet& symbolIs) const
+    {
+      /// Returned list
+      std::vector<size_t> res;
+      
+      symbolIs.forEach([&res](const size_t& iSymbol)
+      {
+	res.push_back(iSymbol);
+      });
+      
+      return res;
+    }
+    
+    /// Computes the first elements
+    ///
+    /// The firsts of the lhs of each production include those of the
+    /// rhs symbols up to the first non-nullable one, the relation is
+    /// solved with the digraph algorithm
+    constexpr void calculateFirsts()
+    {
+      diagnostic("-----------------------------------\n");
+      
+      /// Firsts of each symbol, initialized to the symbol itself if not a non-terminal
+      std::vector<BitSet> firstIs(symbols.size(),BitSet(symbols.size()));
+      
+      /// Symbols whose firsts are included in those of each symbol
+      std::vector<std::vector<size_t>> includesFirstsOf(symbols.size());
+      
+      for(size_t iS=0;iS<symbols.size();iS++)
+	if(symbols[iS].type!=GrammarSymbol::Type::NON_TERMINAL_SYMBOL)
+	  firstIs[iS].set(iS);
+      
+      for(const GrammarProduction& p : productions)
+	{
+	  bool nonNullableFound=false;
+	  for(size_t iRhs=0;iRhs<p.iRhsList.size() and not nonNullableFound;iRhs++)
+	    {
+	      const size_t& iT=p.iRhsList[iRhs];
 	      
-	      if((matchRes.state=matchin.matchChar(';')))
-		diagnostic("Found production statement end\n");
+	      includesFirstsOf[p.iLhs].push_back(iT);
+	      nonNullableFound=not symbols[iT].nullable;
 	    }
 	}
       
-      return matchRes;
+      digraph(firstIs,includesFirstsOf);
+      
+      for(size_t iS=0;iS<symbols.size();iS++)
+	{
+	  GrammarSymbol& s=symbols[iS];
+	  
+	  s.firstIs=std::move(firstIs[iS]);
+	  s.firsts=listSymbols(s.firstIs);
+	  
+	  diagnostic("Symbol ",s.name," firsts:\n");
+	  for(const size_t& iF : s.firsts)
+	    diagnostic("   ",symbols[iF].name,"\n");
+	}
     }
     
-    constexpr bool matchAndParseWhitespaceStatement(StringMatcher& matchin)
+    /// Computes the follow elements
+    ///
+    /// The follows of each rhs symbol include the firsts of the rest
+    /// of the production, and the follows of the lhs if the rest is
+    /// nullable, the latter relation is solved with the digraph
+    /// algorithm
+    constexpr void calculateFollows()
     {
-      /// Undo if not matching
-      auto matchRes=
-	matchin.beginTemptativeMatch("whitespace statement",false);
+      diagnostic("-----------------------------------\n");
       
-      matchin.matchWhiteSpaceOrComments();
+      /// Follows of each symbol, initialized to the firsts of what follows in the productions
+      std::vector<BitSet> followIs(symbols.size(),BitSet(symbols.size()));
       
-      if(matchin.matchStr("%whitespace"))
+      /// Symbols whose follows are included in those of each symbol
+      std::vector<std::vector<size_t>> includesFollowsOf(symbols.size());
+      
+      followIs[iStartSymbol].set(iEndSymbol);
+      
+      for(const GrammarProduction& p : productions)
 	{
-	  diagnostic("Matched whitespace statement\n");
+	  /// Firsts of the part of the production after the current symbol
+	  BitSet firstsAfter(symbols.size());
 	  
-	  matchin.matchWhiteSpaceOrComments();
+	  /// Determine whether the part of the production after the current symbol is nullable
+	  bool nullableAfter=true;
 	  
-	  bool goon=true;;
-	  while(goon)
+	  for(size_t iRhs=p.iRhsList.size();iRhs-->0;)
 	    {
-	      auto l=matchin.matchRegex();
-	      if(not l.empty())
+	      const size_t& iS=p.iRhsList[iRhs];
+	      const GrammarSymbol& s=symbols[iS];
+	      
+	      followIs[iS].insert(firstsAfter);
+	      if(nullableAfter)
+		includesFollowsOf[iS].push_back(p.iLhs);
+	      
+	      if(s.nullable)
+		firstsAfter.insert(s.firstIs);
+	      else
+		firstsAfter=s.firstIs;
+	      nullableAfter&=s.nullable;
+	    }
+	}
+      
+      digraph(followIs,includesFollowsOf);
+      
+      for(size_t iS=0;iS<symbols.size();iS++)
+	{
+	  GrammarSymbol& s=symbols[iS];
+	  
+	  s.followIs=std::move(followIs[iS]);
+	  s.follows=listSymbols(s.followIs);
+	  
+	  diagnostic("Symbol ",s.name," follows:\n");
+	  for(const size_t& iF : s.follows)
+	    diagnostic("   ",symbols[iF].name,"\n");
+	}
+    }
+    
+    /// Set the precedence
+    constexpr void setPrecedence()
+    {
+      diagnostic("-----------------------------------\n");
+      for(auto& p : productions)
+	{
+	  diagnostic("Production \"",describe(p),"\"\n");
+	  for(size_t iiRhs=p.iRhsList.size()-1;iiRhs<p.iRhsList.size() and not p.precedenceSymbol;iiRhs--)
+	    {
+	      const size_t iRhs=p.iRhsList[iiRhs];
+	      diagnostic(" probing symbol ",iRhs," (\"",symbols[iRhs].name,"\"), type: ",(int)symbols[iRhs].type,"\n");
+	      if(symbols[iRhs].type==GrammarSymbol::Type::TERMINAL_SYMBOL)
 		{
-		  whitespaceRegexList.emplace_back(l);
-		  diagnostic("Matched regex ",l,"\n");
-		  matchin.matchWhiteSpaceOrComments();
+		  p.precedenceSymbol=iRhs;
+		  diagnostic(" precedence symbol: ",symbols[iRhs].name,"\n");
 		}
-	      else goon=false;
 	    }
-	  
-	  matchRes.state=matchin.matchChar(';');
 	}
       
-      return matchRes;
+      // // Report the precedence
+      // for(auto& p : productions)
+      //   if(const auto& pp=p.precedenceSymbol)
+      // 	diagnostic("Precedence symbol for production \"",describe(p),"\": ",symbols[*pp].name,"\n");
     }
     
-    /// Adds generic symbols to the symbols list
-    constexpr void addGenericSymbols()
+    /// Pre-compute the closure of each symbol, to anticipate the addition of goto states
+    constexpr void preComputeClosures()
     {
-      using enum GrammarSymbol::Type;
+      diagnostic("-----------------------------------\n");
       
-      for(const auto& [name,type,i] :
-	    {std::make_tuple(".start",NON_TERMINAL_SYMBOL,&iStartSymbol),
-	     {".end",END_SYMBOL,&iEndSymbol},
-	     {".error",NULL_SYMBOL,&iErrorSymbol},
-	     {".whitespace",NULL_SYMBOL,&iWhitespaceSymbol}})
+      for(size_t iSymbol=0;iSymbol<symbols.size();iSymbol++)
 	{
-	  *i=symbols.size();
-	  symbols.emplace_back(name,type);
+	  /// Closure of the symbol
+	  BitSet closure(productions.size());
+	  
+	  for(std::vector<size_t> iSymbolsToVisit{iSymbol};not iSymbolsToVisit.empty();)
+	    {
+	      /// Symbol whose productions are being added
+	      const size_t iVisitedSymbol=iSymbolsToVisit.back();
+	      iSymbolsToVisit.pop_back();
+	      
+	      for(const size_t& iP : symbols[iVisitedSymbol].iProductions)
+		if(not closure.get(iP))
+		  {
+		    closure.set(iP);
+		    
+		    if(const GrammarProduction& p=productions[iP];p.iRhsList.size() and symbols[p.iRhsList.front()].type==GrammarSymbol::Type::NON_TERMINAL_SYMBOL)
+		      iSymbolsToVisit.push_back(p.iRhsList.front());
+		  }
+	    }
+	  
+	  for(size_t iP=0;iP<productions.size();iP++)
+	    if(closure.get(iP))
+	      diagnostic("Symbol \"",symbols[iSymbol].name,"\" has in the closure the production \"",describe(productions[iP]),"\"\n");
+	  
+	  symbols[iSymbol].closureProductions=std::move(closure);
 	}
     }
     
-    /// Matches the passed string into symbols, actions, productions, etc
-    constexpr void parseTheGrammar(const std::string_view& str)
+    /// Generates the states
+    constexpr void generateStates()
     {
-      /// Embeds the string into a matcher
-      StringMatcher match(str);
+      diagnostic("-----------------------------------\n");
       
-      match.matchWhiteSpaceOrComments();
+      stateItemsIndex.maybeAdd(stateItems,GrammarState{{itemsIndex.maybeAdd(items,{symbols[iStartSymbol].iProductions.front(),0}).second}});
+      stateTransitions.resize(1);
       
-      if(auto id=match.matchId();not id.empty())
+      diagnostic("Start state first production: ",describe(productions[symbols[iStartSymbol].iProductions.front()]),"\n");
+      
+      for(std::vector<size_t> iStates{0},iNextStates;iStates.size();iStates=iNextStates)
 	{
-	  name=id;
+	  iNextStates.clear();
 	  
-	  diagnostic("Matched grammar: \"",id,"\", skipped to ",match.ref.begin(),"\n");
+	  /// Goto items of each state of the frontier, listed concurrently if allowed
+	  std::vector<std::vector<std::pair<std::optional<size_t>,GrammarItem>>> listedGotoItems(iStates.size());
 	  
-	  match.matchWhiteSpaceOrComments();
+	  forEachIndex(iStates.size(),[this,&iStates,&listedGotoItems](const size_t& i)
+	  {
+	    listedGotoItems[i]=stateItems[iStates[i]].listGotoItems(items,productions,symbols);
+	  });
 	  
-	  if(match.matchChar('{'))
-	    {
-	      diagnostic("Matched {\n");
-	      
-	      while(matchAndParseAssociativityStatement(match) or
-		    matchAndParseWhitespaceStatement(match) or
-		    matchAndParseProductionStatement(match))
-		diagnostic("parsed some statement\n");
-	      
-	      match.matchWhiteSpaceOrComments();
-	      if(not match.matchChar('}'))
-		diagnostic("Unfinished grammar, reference is: \"",match.ref,"\"\n");
-	      
-	      match.matchWhiteSpaceOrComments();
-	      if(not match.ref.empty())
-		errorEmitter("Unfinished parsing!\n");
-	      else
-		diagnostic("Grammar parsing correctly ended\n");
-	    }
-	  else
-	    errorEmitter("Empty grammar\n");
+	  // Intern the goto items and states in the order of the frontier, to keep the numbering deterministic
+	  for(size_t i=0;i<iStates.size();i++)
+	    for(const size_t& iState=iStates[i];
+		const auto& [iSymbol,gotoState] : GrammarState::createGotoStates(listedGotoItems[i],items,itemsIndex))
+	      if(iSymbol!=iEndSymbol)
+		{
+		  /// Search the goto state in the list of states
+		  const auto [inserted,iGotoState]=stateItemsIndex.maybeAdd(stateItems,gotoState);
+		  
+		  if(inserted)
+		    {
+		      iNextStates.push_back(iGotoState);
+		      stateTransitions.emplace_back();
+		    }
+		  
+		  stateTransitions[iState].emplace_back(iSymbol,iGotoState);
+		  diagnostic("Emplaced in state:\n",describe(stateItems[iState]));
+		  diagnostic(" the transition mediated by symbol \"",symbols[iSymbol].name,"\" to state\n",describe(stateItems[iGotoState]),"\n");
+		}
 	}
-      else
-	errorEmitter("Unmatched id to name the grammar\n");
-    }
-    
-    /// Performs some test of the grammar
-    constexpr void checkTheGrammar()
-    {
-      // Check that all symbols are referenced at least once and defined
-      for(const GrammarSymbol& s : symbols)
-	if(s.type==GrammarSymbol::Type::NON_TERMINAL_SYMBOL and s.iProductions.empty() and not s.referredAsPrecedenceSymbol)
-	  errorEmitter("Undefined symbol");
       
-      /// Count of symbols usage as rhs or precedence
-      std::vector<size_t> symbolsCount(symbols.size(),0);
-      for(const GrammarProduction& production : productions)
+      for(size_t iState=0;iState<stateItems.size();iState++)
 	{
-	  for(const size_t& r : production.iRhsList)
-	    symbolsCount[r]++;
+	  diagnostic("--\n");
 	  
-	  if(auto p=production.precedenceSymbol)
-	    symbolsCount[*p]++;
+	  diagnostic("State:\n",describe(stateItems[iState]));
+	  diagnostic("has ",stateTransitions[iState].size()," transitions:\n");
+	  
+	  if(stateTransitions[iState].size())
+	    for(const GrammarTransition& t : stateTransitions[iState])
+	      diagnostic(describe(t));
 	}
-      
-      // Check that the symbols are used
-      for(size_t iSymbol=0;iSymbol<symbols.size();iSymbol++)
-	if(const std::array<size_t,4> filt{iStartSymbol,iEndSymbol,iErrorSymbol,iWhitespaceSymbol};
-	   std::find(filt.begin(),filt.end(),iSymbol)==filt.end())
-	  if(symbolsCount[iSymbol]==0)
-	    {
-	      diagnostic("Symbol ",symbols[iSymbol].name," ",iSymbol," ",iStartSymbol,"\n");
-	      errorEmitter("Unreferenced symbol");
-	    }
     }
     
-    /// Remove the references to a symbol
-    constexpr void replaceSymbolReference(size_t& iTargetSymbol,
-					  const size_t& iReplacedSymbol,
-					  const size_t& iReplacementSymbol)
+    /// Returns the kernel items of the state, followed by the items at the beginning of the closure productions
+    constexpr std::vector<size_t> closedIItems(const size_t& iState) const
     {
-      // const size_t old=target;
+      /// State to be closed
+      const GrammarState& state=stateItems[iState];
       
-      if(iTargetSymbol==iReplacedSymbol)
-	iTargetSymbol=iReplacementSymbol;
+      /// Returned list of items
+      std::vector<size_t> res=state.iItems;
       
-      if(iTargetSymbol>iReplacedSymbol)
-	iTargetSymbol--;
+      /// Productions of the closure
+      const BitSet closure=state.closureProductions(items,productions,symbols);
       
-      // if(old!=target)
-      //   diagnostic("before was ",old,"now is ",target,"\n");
+      closure.forEach([this,&res](const size_t& iProduction)
+      {
+	res.push_back(*itemsIndex.find(items,{iProduction,0}));
+      });
+      
+      return res;
     }
     
-    /// Replaces all occurrence of the first symbol with that of the second, and remove it from the list
-    constexpr void replaceAndRemoveSymbol(const size_t& iReplacedSymbol,
-					  const size_t& iReplacementSymbol)
+    /// Returns the state reached from the given one through the symbol
+    ///
+    /// Valid as long as the state only contains the shift
+    /// transitions, sorted by symbol, as produced by generateStates
+    constexpr size_t gotoState(const size_t& iState,
+			       const size_t& iSymbol) const
     {
-      /// Checks that noth both symbols declared "what"
-      const auto checkNotBothDeclared=
-	[this,
-	 iReplacedSymbol,
-	 iReplacementSymbol](const size_t& replaced,
-			     const size_t& replacement,
-			     const char* what)
-	{
-	  if(replaced!=0 and replacement!=0)
-	    errorEmitter((std::string("symbol ")+std::string(symbols[iReplacedSymbol].name)+std::string(" to be replaced by ")+std::string(symbols[iReplacementSymbol].name)+std::string(" but both have a declared ")+what).c_str());
-	};
+      /// Transitions of the state
+      const std::vector<GrammarTransition>& transitions=stateTransitions[iState];
       
-      const size_t& replacedPrecedence=symbols[iReplacedSymbol].precedence;
-      size_t& replacementPrecedence=symbols[iReplacementSymbol].precedence;
+      return std::lower_bound(transitions.begin(),transitions.end(),iSymbol,
+			      [](const GrammarTransition& transition,
+				 const size_t& iSymbol)
+			      {
+				return transition.iSymbol<iSymbol;
+			      })->iStateOrProduction;
+    }
+    
+    /// Returns the index of the transition from the given state through the non-terminal symbol
+    constexpr size_t iNonTerminalTransition(const size_t& iState,
+					    const size_t& iSymbol) const
+    {
+      return std::lower_bound(nonTerminalTransitions.begin()+iFirstNonTerminalTransitionOfState[iState],
+			      nonTerminalTransitions.begin()+iFirstNonTerminalTransitionOfState[iState+1],iSymbol,
+			      [](const GrammarNonTerminalTransition& transition,
+				 const size_t& iSymbol)
+			      {
+				return transition.iSymbol<iSymbol;
+			      })-nonTerminalTransitions.begin();
+    }
+    
+    /// Returns the index of the reduction of the production in the state, adding it if not present
+    constexpr size_t iReductionOfState(const size_t& iState,
+				       const size_t& iProduction)
+    {
+      /// Reductions of the state
+      std::vector<GrammarReduction>& reductions=stateReductions[iState];
       
-      checkNotBothDeclared(replacedPrecedence,replacementPrecedence,"precedence");
+      for(size_t iReduction=0;iReduction<reductions.size();iReduction++)
+	if(reductions[iReduction].iProduction==iProduction)
+	  return iReduction;
       
-      if(replacedPrecedence!=0 and replacementPrecedence!=0)
-	errorEmitter((std::string("symbol ")+std::string(symbols[iReplacedSymbol].name)+std::string(" to be replaced by ")+std::string(symbols[iReplacementSymbol].name)+std::string(" but both have a declared precedence")).c_str());
+      reductions.emplace_back(iProduction,BitSet(symbols.size()));
       
-      if(replacedPrecedence)
-	replacementPrecedence=replacedPrecedence;
+      return reductions.size()-1;
+    }
+    
+    /// Generates the lookaheads with the DeRemer-Pennello algorithm
+    ///
+    /// The follow of each non-terminal transition (p,A) is computed
+    /// by closing the directly read symbols first over the "reads"
+    /// relation, then over the "includes" one, then the lookahead of
+    /// each reduction is the union of the follows of the transitions
+    /// it looks back to
+    constexpr void generateLookaheads()
+    {
+      diagnostic("-----------------------------------\n");
       
-      const GrammarSymbol::Associativity& replacedAssociativity=symbols[iReplacedSymbol].associativity;
-      GrammarSymbol::Associativity& replacementAssociativity=symbols[iReplacementSymbol].associativity;
+      for(size_t iState=0;iState<stateItems.size();iState++)
+	{
+	  iFirstNonTerminalTransitionOfState.push_back(nonTerminalTransitions.size());
+	  for(const GrammarTransition& transition : stateTransitions[iState])
+	    if(symbols[transition.iSymbol].type==GrammarSymbol::Type::NON_TERMINAL_SYMBOL)
+	      nonTerminalTransitions.emplace_back(iState,transition.iSymbol,transition.iStateOrProduction);
+	}
+      iFirstNonTerminalTransitionOfState.push_back(nonTerminalTransitions.size());
       
-      checkNotBothDeclared((size_t)replacedAssociativity,(size_t)replacementAssociativity,"associativity");
+      /// Number of non-terminal transitions
+      const size_t nNonTerminalTransitions=nonTerminalTransitions.size();
+      diagnostic("Number of non-terminal transitions: ",nNonTerminalTransitions,"\n");
       
-      if(replacedAssociativity!=GrammarSymbol::Associativity::NONE)
-	replacementAssociativity=replacedAssociativity;
+      /// Follows of each non-terminal transition, initially holding the directly read symbols
+      std::vector<BitSet> follows(nNonTerminalTransitions,BitSet(symbols.size()));
       
-      /// Incapsulate the replacement of the symbol
-      const auto action=
-	[this,
-	 iReplacedSymbol,
-	 iReplacementSymbol](size_t& i)
-	{
-	  replaceSymbolReference(i,iReplacedSymbol,iReplacementSymbol);
-	};
+      /// Transitions whose read symbols are read by each transition, through a nullable symbol
+      std::vector<std::vector<size_t>> reads(nNonTerminalTransitions);
       
-      for(GrammarProduction& p : productions)
-	{
-	  action(p.iLhs);
-	  
-	  for(size_t& iRhs : p.iRhsList)
-	    action(iRhs);
-	  
-	  if(p.precedenceSymbol)
-	    action(*p.precedenceSymbol);
-	}
+      forEachIndex(nNonTerminalTransitions,[this,&follows,&reads](const size_t& iTransition)
+      {
+	for(const size_t& iGotoState=nonTerminalTransitions[iTransition].iGotoState;
+	    const GrammarTransition& transition : stateTransitions[iGotoState])
+	  if(const GrammarSymbol& symbol=symbols[transition.iSymbol];symbol.type!=GrammarSymbol::Type::NON_TERMINAL_SYMBOL)
+	    follows[iTransition].set(transition.iSymbol);
+	  else
+	    if(symbol.nullable)
+	      reads[iTransition].push_back(iNonTerminalTransition(iGotoState,transition.iSymbol));
+      });
       
-      symbols.erase(symbols.begin()+iReplacedSymbol);
-    }
-    
-    /// Removes the given production
-    constexpr void removeProduction(const size_t& iProduction)
-    {
-      diagnostic("Removing production: ",describe(productions[iProduction]),"\n");
+      /// Start production
+      const size_t& iStartProduction=symbols[iStartSymbol].iProductions.front();
       
-      // Remove production from the list
-      productions.erase(productions.begin()+iProduction);
+      // The end symbol is read after the transition over the start production
+      follows[iNonTerminalTransition(0,productions[iStartProduction].iRhsList.front())].set(iEndSymbol);
       
-      // Update the production references
-      for(GrammarSymbol& s : symbols)
-	for(size_t& jProduction : s.iProductions)
-	  if(jProduction>iProduction)
-	    jProduction--;
-    }
-    
-    /// Replaces a non-terminal symbols that is actually named terminals
-    constexpr bool removeOneRedundantProductionIfFound()
-    {
-      bool removed=false;
+      digraph(follows,reads);
       
-      size_t iSymbol=0;
-      while(iSymbol<symbols.size() and not removed)
-	{
-	  if(iSymbol!=iErrorSymbol)
-	    if(GrammarSymbol& symbol=symbols[iSymbol];symbol.iProductions.size()==1)
+      /// Transitions included by each transition, and state and production of the reductions looking back to it, found walking its productions
+      std::vector<std::pair<std::vector<size_t>,std::vector<std::pair<size_t,size_t>>>> walks(nNonTerminalTransitions);
+      
+      forEachIndex(nNonTerminalTransitions,[this,&walks](const size_t& iTransition)
+      {
+	for(const auto& [iState,iSymbol,iGotoState]=nonTerminalTransitions[iTransition];
+	    const size_t& iProduction : symbols[iSymbol].iProductions)
+	  {
+	    /// Production to be walked
+	    const GrammarProduction& production=productions[iProduction];
+	    
+	    /// State reached walking the production
+	    size_t iWalkState=iState;
+	    
+	    for(size_t position=0;position<production.iRhsList.size();position++)
 	      {
-		const size_t /* don't take by reference! */iProduction=symbol.iProductions.front();
+		/// Symbol at the position
+		const size_t& iRhs=production.iRhsList[position];
 		
-		if(const GrammarProduction& production=productions[iProduction];production.iRhsList.size()==1 and production.action.empty())
-		  if(const size_t /* don't take by reference! */ iActualSymbol=production.iRhsList.front();symbols[iActualSymbol].type==GrammarSymbol::Type::TERMINAL_SYMBOL)
-		    {
-		      removed=true;
-		      diagnostic("Symbol \"",symbol.name,"\" with precedence ",symbol.precedence,
-				 " is an alias for the terminal: \"",symbols[iActualSymbol].name,"\" with precedence ",symbols[iActualSymbol].precedence,"\n");
-		      
-		      removeProduction(iProduction);
-		      replaceAndRemoveSymbol(iSymbol,iActualSymbol);
-		    }
+		if(symbols[iRhs].type==GrammarSymbol::Type::NON_TERMINAL_SYMBOL and production.isNullableAfter(symbols,position+1))
+		  walks[iTransition].first.push_back(iNonTerminalTransition(iWalkState,iRhs));
+		
+		iWalkState=gotoState(iWalkState,iRhs);
 	      }
-	  
-	  if(not removed)
-	    iSymbol++;
-	}
+	    
+	    walks[iTransition].second.emplace_back(iWalkState,iProduction);
+	  }
+      });
       
-      return removed;
+      /// Transitions whose follows are included in those of each transition
+      std::vector<std::vector<size_t>> includes(nNonTerminalTransitions);
+      
+      for(size_t iTransition=0;iTransition<nNonTerminalTransitions;iTransition++)
+	for(const size_t& iIncludedTransition : walks[iTransition].first)
+	  includes[iIncludedTransition].push_back(iTransition);
+      
+      digraph(follows,includes);
+      
+      stateReductions.resize(stateItems.size());
+      
+      stateReductions[gotoState(0,productions[iStartProduction].iRhsList.front())].emplace_back(iStartProduction,BitSet(symbols.size())).symbolIs.set(iEndSymbol);
+      
+      /// State and reduction looking back to each non-terminal transition
+      std::vector<std::tuple<size_t,size_t,size_t>> lookbacks;
+      
+      for(size_t iTransition=0;iTransition<nNonTerminalTransitions;iTransition++)
+	for(const auto& [iState,iProduction] : walks[iTransition].second)
+	  lookbacks.emplace_back(iState,iReductionOfState(iState,iProduction),iTransition);
+      
+      forEachIndex(lookbacks.size(),[this,&lookbacks,&follows](const size_t& iLookback)
+      {
+	const auto& [iState,iReduction,iTransition]=lookbacks[iLookback];
+	stateReductions[iState][iReduction].symbolIs.insertConcurrently(follows[iTransition]);
+      });
+      
+      for(size_t iState=0;iState<stateItems.size();iState++)
+	for(const GrammarReduction& reduction : stateReductions[iState])
+	  {
+	    diagnostic("State ",iState," reduces production ",describe(productions[reduction.iProduction])," on the lookahead:\n");
+	    for(const size_t& iSymbol : listSymbols(reduction.symbolIs))
+	      diagnostic("   ",symbols[iSymbol].name,"\n");
+	  }
+    }
+    
+    /// Inserts a reduce transition
+    constexpr void insertReduceTransition(std::vector<GrammarTransition>& transitions,
+					  const size_t& iSymbol,
+					  const size_t& iProduction)
+    {
+      transitions.push_back(GrammarTransition::getReduce(iSymbol,iProduction));
+      diagnostic("        inserting new reduce transitions\n");
     }
     
-    /// Performs grammar optimization
-    constexpr void grammarOptimize()
+    /// Try to solve a shift/reduce conflict
+    constexpr void dealWithShiftReduceConflict(GrammarTransition& transition,
+					       const GrammarSymbol& symbol,
+					       const size_t& iProduction)
     {
-      const auto diag=
-	[this](const char* tag)
-	{
-	  diagnostic("-----------------------------------\n");
-	  diagnostic("list of productions ",tag," optimization:\n");
-	  for(const GrammarProduction& production : productions)
-	    diagnostic(describe(production),"\n");
-	  diagnostic("list of symbols ",tag," optimization:\n");
-	  for(const GrammarSymbol& s : symbols)
-	    diagnostic("symbol ",s.name,"\n");
-	  diagnostic("\n");
-	  diagnostic("-----------------------------------\n");
-	};
-      
-      diag("before");
+      const GrammarProduction& production=productions[iProduction];
+      const size_t productionPrecedence=production.precedence(symbols);
       
-      bool doneSomething;
-      do
-	{
-	  doneSomething=false;
-	  doneSomething|=removeOneRedundantProductionIfFound();
-	}
-      while(doneSomething);
+      if(productionPrecedence==0 or symbol.precedence==0 or
+	 (symbol.precedence==productionPrecedence and symbol.associativity==GrammarSymbol::Associativity::NONE))
+	errorEmitter((std::string("shift/reduce conflict for '")+std::string(symbols[production.iLhs].name)+"' on '"+std::string(symbol.name)+
+		      "' ought to transition: "+describe(transition)+"\nproduction precedence: "+std::to_string(productionPrecedence)+" symbol precedence: "+std::to_string(symbol.precedence)+" symbol associativity: "+std::to_string((int)symbol.associativity)).c_str());
+      else
+	if(productionPrecedence>symbol.precedence or (symbol.precedence==productionPrecedence and symbol.associativity==GrammarSymbol::Associativity::RIGHT))
+	  {
+	    diagnostic("overriding shift ",describe(transition));
+	    transition.type=GrammarTransition::REDUCE;
+	    transition.iStateOrProduction=iProduction;
+	    diagnostic(" into reduce: ",describe(transition));
+	  }
+	else
+	  {
+	    diagnostic("leaving already esisting transition ",describe(transition)," given that ");
+	    if(productionPrecedence<symbol.precedence)
+	      diagnostic(" the production has precedence ",productionPrecedence," lesser than the symbol ",symbol.precedence);
+	    else
+	      diagnostic(" the production has the same precedence ",productionPrecedence," of the symbol ,which has associatity",(int)symbol.associativity,
+			 " different from right (",(int)GrammarSymbol::Associativity::RIGHT);
+	  }
+    }
+    
+    /// Try to solve a reduce/reduce conflict
+    constexpr void dealWithReduceReduceConflict(GrammarTransition& transition,
+						const GrammarSymbol& symbol,
+						const size_t& iProduction)
+    {
+      const GrammarProduction& production=productions[iProduction];
+      const size_t productionPrecedence=production.precedence(symbols);
       
-      diag("after");
+      if(const size_t& transitionPrecedence=productions[transition.iStateOrProduction].precedence(symbols);productionPrecedence==0 or transitionPrecedence==0 or
+	 productionPrecedence==transitionPrecedence)
+	errorEmitter((std::string("reduce/reduce conflict for '")+std::string(symbols[production.iLhs].name)+"' on '"+std::string(symbol.name)+
+		      "' ought to transition: "+describe(transition)+"\nproduction precedence: "+std::to_string(productionPrecedence)+" transition precedence: "+std::to_string(transitionPrecedence)).c_str());
+      else
+	if(productionPrecedence>transitionPrecedence)
+	  {
+	    diagnostic("overriding reduce: ",describe(transition));
+	    transition.iStateOrProduction=iProduction;
+	    diagnostic(" into reduce: ",describe(transition));
+	  }
+	else
+	  diagnostic("leaving already esisting transition ",describe(transition)," given that the production has precedence ",productionPrecedence," lesser than the transition ",transitionPrecedence);
     }
     
-    /// Computes the first elements
-    constexpr void calculateFirsts()
+    /// Generate reduce or shift transitions
+    constexpr void generateTransitions()
     {
-      // Calculate firsts
       diagnostic("-----------------------------------\n");
       
-      for(size_t nAdded=1;nAdded;)
-	{
-	  nAdded=0;
-	  for(size_t iS=0;iS<symbols.size();iS++)
+      iDefaultReductionOfState.resize(stateItems.size());
+      
+      forEachIndex(stateItems.size(),[this](const size_t& iState)
+      {
+	bool stateDescribed=0;
+	GrammarState& state=stateItems[iState];
+	std::vector<GrammarTransition>& transitions=stateTransitions[iState];
+	
+	/// Value marking the absence of a transition for a symbol
+	constexpr size_t noTransition=std::numeric_limits<size_t>::max();
+	
+	/// Position of the transition of each symbol in the state
+	std::vector<size_t> iTransitionOfSymbol(symbols.size(),noTransition);
+	for(size_t iTransition=0;iTransition<transitions.size();iTransition++)
+	  iTransitionOfSymbol[transitions[iTransition].iSymbol]=iTransition;
+	
+	for(const GrammarReduction& reduction : stateReductions[iState])
+	  {
+	    bool reductionDescribed=0;
+	    const size_t& iProduction=reduction.iProduction;
+	    const GrammarProduction& production=productions[iProduction];
+	    
+	    reduction.symbolIs.forEach([this,
+					&state,
+					&transitions,
+					&iTransitionOfSymbol,
+					&stateDescribed,
+					&reductionDescribed,
+					&production,
+					&iProduction](const size_t& iSymbol)
 	    {
-	      /// \todo: loop only on non terminal, do the terminal part apart
+	      const GrammarSymbol& symbol=symbols[iSymbol];
 	      
-	      GrammarSymbol& s=symbols[iS];
-	      diagnostic("Processing symbol ",s.name,"\n");
+	      if(not stateDescribed)
+		{
+		  diagnostic("State: \n",describe(state));
+		  stateDescribed=true;
+		}
 	      
-	      if(s.type==GrammarSymbol::Type::NON_TERMINAL_SYMBOL)
-		for(const size_t& iP : s.iProductions)
-		  {
-		    const GrammarProduction& p=productions[iP];
-		    diagnostic("  Processing production ",iP,", lhs: ",symbols[p.iLhs].name," before added: ",nAdded,", rhs size: ",p.iRhsList.size(),"\n");
-		    
-		    bool nonNullableFound=false;
-		    for(size_t iRhs=0;iRhs<p.iRhsList.size() and not nonNullableFound;iRhs++)
-		      {
-			const size_t iT=p.iRhsList[iRhs];
-			nonNullableFound|=not symbols[iT].nullable;
-			diagnostic("  Not at symbols end, adding ",symbols[iT].name,"\n");
-			
-			diagnostic("  Symbol ",symbols[iT].name," firsts:\n");
-			for(const auto& iF : symbols[iT].firsts)
-			  {
-			    diagnostic("   ",symbols[iF].name,"\n");
-			    
-			    const bool isAdded=maybeAddToUniqueVector(s.firsts,iF).first;
-			    nAdded+=isAdded;
-			    
-			    if(isAdded)
-			      diagnostic("   added ",symbols[iF].name,"\n");
-			  }
-		      }
-		    
-		    if(not nonNullableFound)
-		      {
-			if(not s.nullable)
-			  {
-			    diagnostic("nullable changed\n");
-			    nAdded++;
-			  }
-			s.nullable=true;
-		      }
-		  }
-	      else
-		nAdded+=maybeAddToUniqueVector(s.firsts,iS).first;
+	      if(not reductionDescribed)
+		{
+		  diagnostic("   production ",describe(production),"\n     reduces:\n");
+		  reductionDescribed=true;
+		}
 	      
-	      diagnostic("  nadded: ",nAdded,"\n");
-	    }
-	  diagnostic("Finished looping on all symbols to find firsts, nAdded: ",nAdded,"\n");
-	}
-      
-      // for(const GrammarSymbol& s : symbols)
-      //   {
-      // 	diagnostic("symbol ",s.name," firsts:\n");
-      // 	for(const auto& iF : s.firsts)
-      // 	  diagnostic("   ",symbols[iF].name,"\n");
-      //   }
+	      diagnostic("      at symbol ",symbols[iSymbol].name,"\n");
+	      
+	      if(size_t& iTransition=iTransitionOfSymbol[iSymbol];iTransition==noTransition)
+		{
+		  iTransition=transitions.size();
+		  insertReduceTransition(transitions,iSymbol,iProduction);
+		}
+	      else
+		{
+		  diagnostic("!!!!panic! state\n",describe(state)," has already transition:\n",describe(transitions[iTransition])," for symbol \'",symbol.name,"\'\n");
+		  
+		  if(GrammarTransition& transition=transitions[iTransition];transition.type==GrammarTransition::Type::SHIFT)
+		    dealWithShiftReduceConflict(transition,symbol,iProduction);
+		  else
+		    dealWithReduceReduceConflict(transition,symbol,iProduction);
+		}
+	    });
+	  }
+	
+	iDefaultReductionOfState[iState]=defaultReduction(transitions);
+      });
     }
     
-    /// Computes the follow elements
-    constexpr void calculateFollows()
+    /// Returns the most frequent reduction among the transitions, if any, which can be taken regardless of the lookahead
+    ///
+    /// The reduction of the start production is never taken as
+    /// default, since it must check that the input is over
+    constexpr std::optional<size_t> defaultReduction(const std::vector<GrammarTransition>& transitions) const
     {
-      diagnostic("-----------------------------------\n");
+      /// Reduced productions, sorted to count their frequency
+      std::vector<size_t> iProductions;
+      for(const GrammarTransition& transition : transitions)
+	if(transition.type==GrammarTransition::REDUCE and productions[transition.iStateOrProduction].iLhs!=iStartSymbol)
+	  iProductions.push_back(transition.iStateOrProduction);
+      std::sort(iProductions.begin(),iProductions.end());
       
-      symbols[iStartSymbol].follows.emplace_back(iEndSymbol);
-      for(size_t nAdded=1;nAdded;)
+      /// Most frequent reduction and its frequency
+      std::pair<std::optional<size_t>,size_t> mostFrequent{};
+      for(size_t i=0,j;i<iProductions.size();i=j)
 	{
-	  nAdded=0;
-	  for(size_t iS=0;iS<symbols.size();iS++)
-	    {
-	      GrammarSymbol& s=symbols[iS];
-	      // diagnostic("Processing symbol ",s.name,"\n");
-	      
-	      for(const size_t& iP : s.iProductions)
-		{
-		  const GrammarProduction& p=productions[iP];
-		  // diagnostic("  Processing production ",iP,", lhs: ",symbols[p.lhs].name," before added: ",added,", rhs size: ",p.rhs.size(),"\n");
-		  // for(const size_t& iS : p.rhs)
-		  //   diagnostic("  ",symbols[iS].name," ",iS,"\n");
-		  
-		  bool nonNullableFound=false;
-		  size_t iLastBeforeOut=p.iRhsList.size()-1;
-		  for(size_t iRhs=p.iRhsList.size()-1;iRhs<p.iRhsList.size() and not nonNullableFound;iRhs--)
-		    {
-		      GrammarSymbol& curSymbol=symbols[p.iRhsList[iRhs]];
-		      for(const auto& iF : s.follows)
-			{
-			  const bool isAdded=maybeAddToUniqueVector(curSymbol.follows,iF).first;
-			  nAdded+=isAdded;
-			  // if(isAdded)
-			  //   diagnostic("   Added ",symbols[iF].name," from follows to follows of ",curSymbol.name,"\n");
-			}
-		      
-		      nonNullableFound|=not curSymbol.nullable;
-		      
-		      iLastBeforeOut=iRhs;
-		    }
-		  
-		  for(size_t iRhs=0;iRhs+1<p.iRhsList.size();iRhs++)
-		    {
-		      // diagnostic("checking previous iRhs ",iRhs," , ",symbols[p.rhs[iRhs]].name," and symbol iLastBeforeOut ",iLastBeforeOut," , ",symbols[p.rhs[iLastBeforeOut]].name,"\n");
-		      for(const auto& iF : symbols[p.iRhsList[iLastBeforeOut]].firsts)
-			{
-			  const bool isAdded=maybeAddToUniqueVector(symbols[p.iRhsList[iRhs]].follows,iF).first;
-			  nAdded+=isAdded;
-			  // if(isAdded)
-			  //   diagnostic("   Added ",symbols[iF].name," from firsts (",std::to_string(1+nonNullableFound),") of ",symbols[p.rhs[iLastBeforeOut]].name," to follows of ",symbols[p.rhs[iRhs]].name,"\n");
-			}
-		    }
-		}
-	    }
+	  for(j=i;j<iProductions.size() and iProductions[j]==iProductions[i];j++);
 	  
-	  diagnostic("Finished looping on all symbols to find follows, added something: ",nAdded,"\n");
+	  if(j-i>mostFrequent.second)
+	    mostFrequent={iProductions[i],j-i};
 	}
       
-      // for(const GrammarSymbol& s : symbols)
-      //   {
-      // 	diagnostic("symbol ",s.name," follows:\n");
-      // 	for(const auto& iF : s.follows)
-      // 	  diagnostic("   ",symbols[iF].name,"\n");
-      //   }
+      return mostFrequent.first;
     }
     
-    /// Set the precedence
-    constexpr void setPrecedence()
+    /// Determines whether the terminal belongs to the lexer mode
+    ///
+    /// The terminals not listed in any mode belong to the initial one
+    constexpr bool belongsToLexerMode(const size_t& iSymbol,
+				      const size_t& iMode) const
     {
-      diagnostic("-----------------------------------\n");
-      for(auto& p : productions)
+      if(iMode==0 and std::ranges::none_of(lexerModes,
+					   [&iSymbol](const GrammarLexerMode& mode)
+					   {
+					     return mode.lists(iSymbol);
+					   }))
+	return true;
+      
+      return iMode<lexerModes.size() and lexerModes[iMode].lists(iSymbol);
+    }
+    
+    /// Lists the regexes recognized by the lexer, setting the symbol of each of them
+    ///
+    /// When lexer modes are declared, only the terminals of the
+    /// initial mode are recognized
+    constexpr std::vector<std::string_view> listRegexes()
+    {
+      /// List of regex paired to the token to be returned
+      std::vector<std::string_view> regexes;
+      
+      for(const std::string_view& w : whitespaceRegexList)
 	{
-	  diagnostic("Production \"",describe(p),"\"\n");
-	  for(size_t iiRhs=p.iRhsList.size()-1;iiRhs<p.iRhsList.size() and not p.precedenceSymbol;iiRhs--)
-	    {
-	      const size_t iRhs=p.iRhsList[iiRhs];
-	      diagnostic(" probing symbol ",iRhs," (\"",symbols[iRhs].name,"\"), type: ",(int)symbols[iRhs].type,"\n");
-	      if(symbols[iRhs].type==GrammarSymbol::Type::TERMINAL_SYMBOL)
-		{
-		  p.precedenceSymbol=iRhs;
-		  diagnostic(" precedence symbol: ",symbols[iRhs].name,"\n");
-		}
-	    }
+	  regexes.emplace_back(w);
+	  iSymbolOfRegex.push_back(iWhitespaceSymbol);
 	}
       
-      // // Report the precedence
-      // for(auto& p : productions)
-      //   if(const auto& pp=p.precedenceSymbol)
-      // 	diagnostic("Precedence symbol for production \"",describe(p),"\": ",symbols[*pp].name,"\n");
+      for(size_t iSymbol=0;iSymbol<symbols.size();iSymbol++)
+	if(symbols[iSymbol].type==GrammarSymbol::Type::TERMINAL_SYMBOL and belongsToLexerMode(iSymbol,0))
+	  {
+	    regexes.emplace_back(symbols[iSymbol].name);
+	    iSymbolOfRegex.push_back(iSymbol);
+	  }
+      
+      diagnostic("List of TERMINAL and whitespaces regex recognized by the grammar, and corresponding token id:\n");
+      for(size_t iRegex=0;iRegex<regexes.size();iRegex++)
+	diagnostic("   ",regexes[iRegex]," -> ",iSymbolOfRegex[iRegex],"\n");
+      
+      return regexes;
     }
     
-    /// Pre-compute goto states to anticipate their additions
-    constexpr void preComputeGotoStates()
+    /// Generate the regex matcher
+    ///
+    /// The tokens recognized by the matcher are replaced with the
+    /// corresponding symbols, so that the parser can use them directly
+    constexpr void generateRegexMatcher(const std::vector<std::string_view>& regexes)
     {
-      diagnostic("-----------------------------------\n");
+      regexMatcher=createRegexMatcher(regexes);
       
-      // diagnostic("Productions--------\n");
-      // for(const GrammarProduction& p : productions)
-      //   diagnostic(describe(p),"\n");
-      // diagnostic("Productions end--------\n");
+      for(RegexMatcherDState& dState : regexMatcher.dStates)
+	if(dState.accepting)
+	  dState.iToken=iSymbolOfRegex[dState.iToken];
       
-      //int i=0;
-      for(GrammarSymbol& s : symbols)
+      generateLexerModesRegexMatchers();
+      
+      findStructuralCharacters();
+    }
+    
+    /// Generates the regex matchers of the lexer modes but the initial one
+    constexpr void generateLexerModesRegexMatchers()
+    {
+      for(size_t iMode=1;iMode<lexerModes.size();iMode++)
 	{
-	  std::vector<size_t> reachable;
-	  
-	  const auto lookForRachableProductionsOfSymbol=
-	    [this,&reachable](const auto& self,
-			      GrammarSymbol& curS)->void
+	  /// Regexes of the mode, and their symbols
+	  std::vector<std::string_view> regexes;
+	  std::vector<size_t> iSymbolOfModeRegex;
+	  for(const auto& [iSymbol,iNextMode] : lexerModes[iMode].iTerminalsAndNextModes)
 	    {
-	      for(const size_t& iP : curS.iProductions)
-		if(const GrammarProduction& p=productions[iP];p.iRhsList.size())
-		  {
-		    /// Production reached by the first symbol, potentially included in the list
-		    //for(size_t j=0;j<i;j++) diagnostic(" ");
-		    diagnostic("testing production ",describe(productions[iP])," \n");
-		    if(maybeAddToUniqueVector(reachable,iP).first)
-		      {
-			//for(size_t j=0;j<i;j++) diagnostic(" ");
-			//i+=3;
-			self(self,symbols[productions[iP].iRhsList.front()]);
-			//i-=3;
-		      }
-		    else
-		      {
-			//for(size_t j=0;j<i;j++) diagnostic(" ");
-			diagnostic(" Not inserting it\n");
-		      }
-		  }
-	    };
+	      regexes.push_back(symbols[iSymbol].name);
+	      iSymbolOfModeRegex.push_back(iSymbol);
+	    }
 	  
-	  lookForRachableProductionsOfSymbol(lookForRachableProductionsOfSymbol,s);
+	  /// Matcher of the mode
+	  RegexMatcher& matcher=lexerModes[iMode].regexMatcher;
 	  
-	  for(const size_t& iP : reachable)
+	  if(not regexes.empty())
 	    {
-	      diagnostic("->     actually inserting production ",describe(productions[iP])," which allows to reach ",s.name,", first symbol: ",symbols[productions[iP].iRhsList.front()].name,"\n");
-	      s.iProductionsReachableByFirstSymbol.push_back(iP);
+	      matcher=createRegexMatcher(regexes);
+	      
+	      for(RegexMatcherDState& dState : matcher.dStates)
+		if(dState.accepting)
+		  dState.iToken=iSymbolOfModeRegex[dState.iToken];
 	    }
 	}
-      
-      for(const GrammarSymbol& s : symbols)
-	for(const size_t& iP :  s.iProductionsReachableByFirstSymbol)
-	  diagnostic("Symbol \"",s.name,"\" can be reached through production \"",describe(productions[iP]),"\" whose first symbol is \"",symbols[productions[iP].iRhsList.front()].name,"\"\n");
     }
     
-    /// Generates the states
-    constexpr void generateStates()
+    /// Finds the characters delimiting the strings, returning whether each state of the lexer is inside a string
+    ///
+    /// A character delimits the strings if the lexer moves on it from
+    /// the initial state to a non-accepting state, from which it can
+    /// only reach non-accepting states until meeting the same
+    /// character, which leads to a state accepting the string without
+    /// further transitions. The backslash escapes the next character
+    /// if it leads to states in which the delimiter does not close the
+    /// string, and from which any character moves back inside it.
+    /// Outside the strings, the lexer must only meet the delimiter at
+    /// the begin of a token, so that the strings can be followed
+    /// without lexing. The delimiters violating this are discarded,
+    /// until all the remaining ones satisfy it
+    constexpr std::vector<bool> findStringDelimiters(const std::vector<bool>& hasTransitions)
     {
-      diagnostic("-----------------------------------\n");
-      
-      stateItems.emplace_back(std::vector<size_t>{0});
-      stateTransitions.resize(1);
-      
-      items.emplace_back(symbols[iStartSymbol].iProductions.front(),0);
+      stringDelimiterOfChar.fill(StringDelimiter::NONE);
       
-      const size_t iStartState=0;
-      stateItems[iStartState].addClosure(items,productions,symbols);
-      
-      diagnostic("Start state first production: ",describe(productions[symbols[iStartSymbol].iProductions.front()]),"\n");
+      /// Role of a state of the lexer with respect to the strings opened by a delimiter
+      enum Role : uint8_t{OUTSIDE,INSIDE,ESCAPED,CLOSING};
       
-      for(std::vector<size_t> iStates{0},iNextStates;iStates.size();iStates=iNextStates)
-	{
-	  iNextStates.clear();
-	  
-	  for(const size_t& iState : iStates)
-	    for(size_t iSymbol=0;iSymbol<symbols.size();iSymbol++)
-	      if(iSymbol!=iEndSymbol)
-		if(const GrammarState gotoState=stateItems[iState].createGotoState(iSymbol,items,productions,symbols);gotoState.iItems.size())
-		  {
-		    /// Search the goto state in the list of states
-		    const auto [inserted,iGotoState]=maybeAddToUniqueVector(stateItems,gotoState);
-		    
-		    if(inserted)
-		      {
-			iNextStates.push_back(iGotoState);
-			stateTransitions.emplace_back();
-		      }
-		    
-		    stateTransitions[iState].emplace_back(iSymbol,iGotoState);
-		    diagnostic("Emplaced in state:\n",describe(stateItems[iState]));
-		    diagnostic(" the transition mediated by symbol \"",symbols[iSymbol].name,"\" to state\n",describe(stateItems[iGotoState]),"\n");
-		    
-		  }
-	}
+      /// Number of states of the lexer
+      const size_t nDStates=regexMatcher.dStates.size();
       
-      for(size_t iState=0;iState<stateItems.size();iState++)
+      /// Determines whether the delimiter leads from the state to a state only accepting the string
+      const auto closesString=
+	[this,
+	 &hasTransitions](const size_t& dState,
+			  const char& delimiter)
 	{
-	  diagnostic("--\n");
+	  /// State reached through the delimiter
+	  const std::optional<size_t> next=regexMatcher.nextDState(dState,delimiter);
 	  
-	  diagnostic("State:\n",describe(stateItems[iState]));
-	  diagnostic("has ",stateTransitions[iState].size()," transitions:\n");
-	  
-	  if(stateTransitions[iState].size())
-	    for(const GrammarTransition& t : stateTransitions[iState])
-	      diagnostic(describe(t));
-	}
-      
-      for(auto& s : stateItems)
-	s.addClosure(items,productions,symbols);
-    }
-    
-    /// Generates the spontaneous lookeaheads
-    constexpr void generateSpontaneousLookahead()
-    {
-      diagnostic("-----------------------------------\n");
+	  return next and regexMatcher.acceptedToken(*next) and not hasTransitions[*next];
+	};
       
-      lookaheads.resize(items.size(),symbols.size());
-      diagnostic("Building the lookaheds for ",symbols.size()," symbols, read from lookaheads: ",lookaheads.front().symbolIs.n," nchars: ",lookaheads.front().symbolIs.data.size(),"\n");
-      lookaheads[0].symbolIs.set(iEndSymbol);
+      /// Candidate delimiters, with the role of each state and whether the backslash escapes
+      std::vector<std::tuple<char,std::vector<Role>,bool>> candidates;
       
-      for(const GrammarState& state : stateItems)
-	for(const size_t iItem : state.iItems)
+      for(size_t c=0;c<256;c++)
+	if(const std::optional<size_t> opening=regexMatcher.nextDState(0,(char)c);opening and *opening!=0 and not regexMatcher.acceptedToken(*opening))
 	  {
-	    const GrammarItem& item=items[iItem];
-	    const size_t& iProduction=item.iProduction;
-	    const GrammarProduction& production=productions[iProduction];
+	    /// Delimiter
+	    const char delimiter=(char)c;
+	    
+	    /// Role of each state
+	    std::vector<Role> roles(nDStates,OUTSIDE);
+	    roles[*opening]=INSIDE;
+	    
+	    /// States inside the string to be visited
+	    std::vector<size_t> queue{*opening};
 	    
-	    diagnostic("Considering item ",describe(item),"\n");
+	    /// Determines whether the lexer follows the role assigned to the states
+	    bool isConsistent=true;
 	    
-	    if(item.position<production.iRhsList.size())
+	    /// Determines whether the backslash escapes, or not, the next character in some state
+	    bool hasEscapes=false,hasUnescapingBackslash=false;
+	    
+	    for(size_t iQueue=0;iQueue<queue.size() and isConsistent;iQueue++)
 	      {
-		const size_t iSymbol=production.iRhsList[item.position];
-		const GrammarSymbol& symbol=symbols[iSymbol];
-		diagnostic(" at symbol: ",symbol.name,"\n");
+		/// State to visit
+		const size_t dState=queue[iQueue];
 		
-		std::vector<size_t> toIns;
-		for(size_t nonNullable=0,iOtherPosition=item.position+1;iOtherPosition<production.iRhsList.size() and nonNullable==0;iOtherPosition++)
-		  {
-		    const size_t iOtherSymbol=production.iRhsList[iOtherPosition];
-		    const GrammarSymbol& otherSymbol=symbols[iOtherSymbol];
-		    
-		    for(const size_t& iFirst : otherSymbol.firsts)
-		      toIns.push_back(iFirst);
-		    
-		    nonNullable+=not otherSymbol.nullable;
-		  }
+		isConsistent&=not regexMatcher.acceptedToken(dState);
 		
-		for(const size_t& iOtherProduction : symbol.iProductions)
+		for(size_t iTransition=regexMatcher.dStates[dState].transitionsBegin;
+		    iTransition<regexMatcher.transitions.size() and regexMatcher.transitions[iTransition].iDStateFrom==dState;
+		    iTransition++)
 		  {
-		    diagnostic(" Searching for production ",describe(productions[iOtherProduction]),"\n");
+		    /// Transition to follow
+		    const RegexMatcherDStateTransition& transition=regexMatcher.transitions[iTransition];
 		    
-		    for(const size_t iOtherItem : state.iItems)
-		      if(items[iOtherItem]==GrammarItem{iOtherProduction,0})
-			{
-			  diagnostic("Adding to lookahead of item ",describe(items[iOtherItem])," the symbols: \n");
-			  for(const size_t& iIns : toIns)
+		    /// State reached
+		    const size_t next=transition.nextDState;
+		    
+		    for(int i=transition.beg;i<transition.end;i++)
+		      {
+			/// Character of the transition
+			const char c=(char)i;
+			
+			/// Role that the reached state must have
+			Role expected=INSIDE;
+			
+			if(roles[dState]==INSIDE)
+			  {
+			    if(c==delimiter)
+			      expected=CLOSING;
+			    else
+			      if(c=='\\')
+				{
+				  if(closesString(next,delimiter))
+				    hasUnescapingBackslash=true;
+				  else
+				    {
+				      hasEscapes=true;
+				      expected=ESCAPED;
+				    }
+				}
+			  }
+			
+			if(next==0 or (expected==CLOSING and not closesString(dState,delimiter)))
+			  isConsistent=false;
+			else
+			  if(roles[next]==OUTSIDE)
 			    {
-			      lookaheads[iOtherItem].symbolIs.set(iIns);
-			      // for(const char& c : lookaheads[iOtherItem].data)
-			      //   diagnostic(lookaheads[iOtherItem].data.size()," -> ",(int)c,"\n");
-			      // diagnostic("\n");
-			      diagnostic("  ",symbols[iIns].name,"\n");
+			      roles[next]=expected;
+			      if(expected!=CLOSING)
+				queue.push_back(next);
 			    }
-			}
+			  else
+			    isConsistent&=(roles[next]==expected);
+		      }
 		  }
 	      }
+	    
+	    if(isConsistent and not (hasEscapes and hasUnescapingBackslash))
+	      candidates.emplace_back(delimiter,std::move(roles),hasEscapes);
 	  }
       
-      diagnostic("---\n");
-      for(size_t iItem=0;iItem<lookaheads.size();iItem++)
-	{
-	  diagnostic("Item ",describe(items[iItem])," contains the following lookahead:\n");
-	  for(size_t iSymbol=0;iSymbol<symbols.size();iSymbol++)
-	    if(lookaheads[iItem].symbolIs.get(iSymbol))
-	      diagnostic("   ",symbols[iSymbol].name,"\n");
-	  diagnostic("---\n");
-	}
-    }
-    
-    /// Generate goto items
-    constexpr void generateGotoItems()
-    {
-      diagnostic("-----------------------------------\n");
+      /// Determines whether each state is inside the strings opened by any candidate
+      std::vector<bool> isInsideString(nDStates);
       
-      for(size_t iState=0;iState<stateItems.size();iState++)
+      /// Determines whether some candidate has been discarded
+      bool discarded;
+      
+      do
 	{
-	  for(const GrammarTransition& transition : stateTransitions[iState])
-	    for(const size_t& iItem : stateItems[iState].iItems)
-	      {
-		const GrammarItem& item=items[iItem];
-		// const GrammarSymbol& symbol=symbols[transition.iSymbol];
-		const GrammarProduction& production=productions[item.iProduction];
-		if(production.iRhsList.size() and production.iRhsList[item.position]==transition.iSymbol)
-		  maybeAddToUniqueVector(lookaheads[iItem].iPropagateToItems,*stateItems[transition.iStateOrProduction].findItem(items,{item.iProduction,item.position+1}));
-	      }
+	  std::fill(isInsideString.begin(),isInsideString.end(),false);
+	  for(const auto& [delimiter,roles,hasEscapes] : candidates)
+	    for(size_t dState=0;dState<nDStates;dState++)
+	      if(roles[dState]==INSIDE or roles[dState]==ESCAPED)
+		isInsideString[dState]=true;
 	  
-	  for(const size_t& iItem : stateItems[iState].iItems)
+	  discarded=
+	    std::erase_if(candidates,[this,
+				      &isInsideString](const auto& candidate)
 	    {
-	      const GrammarItem& item=items[iItem];
-	      const GrammarProduction& production=productions[item.iProduction];
+	      const auto& [delimiter,roles,hasEscapes]=candidate;
 	      
-	      if(const size_t& position=item.position;
-		 position<production.iRhsList.size() and production.isNullableAfter(symbols,position+1))
-		for(const size_t& iOtherProduction : symbols[production.iRhsList[position]].iProductions)
+	      for(const RegexMatcherDStateTransition& transition : regexMatcher.transitions)
+		if(const size_t& from=transition.iDStateFrom;transition.beg<transition.end and roles[from]!=INSIDE and roles[from]!=ESCAPED)
 		  {
-		    if(const std::optional<size_t> maybeIGotoItem=stateItems[iState].findItem(items,{iOtherProduction,0}))
-		      maybeAddToUniqueVector(lookaheads[iItem].iPropagateToItems,*maybeIGotoItem);
+		    /// Determines whether the transition is the opening of the string
+		    const bool isOpening=
+		      from==0 and transition.beg==delimiter and transition.end==delimiter+1;
+		    
+		    /// Determines whether the transition is on the delimiter
+		    const bool isOnDelimiter=
+		      transition.beg<=delimiter and transition.end>delimiter;
+		    
+		    if((roles[transition.nextDState]!=OUTSIDE and not isOpening) or
+		       (isOnDelimiter and from!=0 and not isInsideString[from]))
+		      return true;
 		  }
-	    }
+	      
+	      return false;
+	    });
 	}
+      while(discarded);
       
-      diagnostic("---\n");
-      for(size_t iItem=0;iItem<lookaheads.size();iItem++)
+      for(const auto& [delimiter,roles,hasEscapes] : candidates)
 	{
-	  diagnostic("$ lookahead of symbols\n");
-	  for(size_t iS=0;iS<symbols.size();iS++)
-	    if(lookaheads[iItem].symbolIs.get(iS))
-	      diagnostic("   ",symbols[iS].name,"\n");
-	  diagnostic("has item ",describe(items[iItem])," propagates to:\n");
-	  for(const size_t& iPropagateTo : lookaheads[iItem].iPropagateToItems)
-	    diagnostic("   ",describe(items[iPropagateTo]),"\n");
+	  diagnostic("Character ",delimiter," delimits strings",hasEscapes?" with escapes":"","\n");
+	  stringDelimiterOfChar[(unsigned char)delimiter]=hasEscapes?StringDelimiter::WITH_ESCAPES:StringDelimiter::WITHOUT_ESCAPES;
 	}
+      
+      return isInsideString;
     }
     
-    constexpr void propagateLookaheads()
+    /// Finds the characters which always form a token by themselves
+    ///
+    /// A character is structural if the lexer moves on it from the
+    /// initial state to a state accepting a non-whitespace token
+    /// without further transitions, and no other state has a
+    /// transition on it, but those inside the strings, so that it can
+    /// never appear inside another token. The same holds for all the
+    /// states of the lexer modes but the initial one
+    constexpr void findStructuralCharacters()
     {
-      // Propagates lookahead
       diagnostic("-----------------------------------\n");
-      std::vector<size_t> iLookaheadsToInsert(lookaheads.size());
-      std::iota(iLookaheadsToInsert.begin(),iLookaheadsToInsert.end(),0);
-      for(std::vector<size_t> nextLookaheads;not iLookaheadsToInsert.empty();iLookaheadsToInsert.swap(nextLookaheads))
+      
+      iStructuralSymbolOfChar.fill(noStructuralSymbol);
+      
+      /// Determines whether some state but the initial one and those inside the strings has a transition on the character
+      std::array<bool,256> continuesToken{};
+      
+      /// Determines whether each state has any non-empty transition
+      std::vector<bool> hasTransitions(regexMatcher.dStates.size());
+      
+      for(const RegexMatcherDStateTransition& transition : regexMatcher.transitions)
+	if(transition.beg<transition.end)
+	  hasTransitions[transition.iDStateFrom]=true;
+      
+      /// Determines whether each state is inside a string
+      const std::vector<bool> isInsideString=
+	findStringDelimiters(hasTransitions);
+      
+      for(const RegexMatcherDStateTransition& transition : regexMatcher.transitions)
+	if(transition.iDStateFrom!=0 and not isInsideString[transition.iDStateFrom])
+	  for(int c=transition.beg;c<transition.end;c++)
+	    continuesToken[(unsigned char)c]=true;
+      
+      for(size_t iMode=1;iMode<lexerModes.size();iMode++)
+	for(const RegexMatcherDStateTransition& transition : lexerModes[iMode].regexMatcher.transitions)
+	  for(int c=transition.beg;c<transition.end;c++)
+	    continuesToken[(unsigned char)c]=true;
+      
+      for(size_t c=0;c<256;c++)
+	if(const std::optional<size_t> next=regexMatcher.nextDState(0,(char)c);next and not continuesToken[c] and not hasTransitions[*next])
+	  if(const std::optional<size_t> iToken=regexMatcher.acceptedToken(*next);iToken and *iToken!=iWhitespaceSymbol)
+	    {
+	      diagnostic("Character ",(char)c," is structural for symbol ",symbols[*iToken].name,"\n");
+	      iStructuralSymbolOfChar[c]=*iToken;
+	    }
+    }
+    
+    /// Generates a regex matcher for each distinct set of terminals valid in some state
+    ///
+    /// Each matcher recognizes the whitespaces and only the terminals
+    /// which have an action in the states using it, so that it is
+    /// smaller than the whole lexer, and terminals matching the same
+    /// text are told apart by the state. The matchers are not
+    /// generated by default, being only needed by parseContextual
+    constexpr void generateContextRegexMatchers()
+    {
+      contextRegexMatchers.clear();
+      iContextRegexMatcherOfState.resize(stateTransitions.size());
+      
+      /// Terminals valid in the states using each matcher
+      std::vector<std::vector<size_t>> validTerminalsOfMatcher;
+      
+      for(size_t iState=0;iState<stateTransitions.size();iState++)
 	{
-	  nextLookaheads.clear();
+	  /// Terminals having an action in the state, sorted
+	  std::vector<size_t> validTerminals;
+	  for(const GrammarTransition& transition : stateTransitions[iState])
+	    if(symbols[transition.iSymbol].type==GrammarSymbol::Type::TERMINAL_SYMBOL and std::ranges::find(validTerminals,transition.iSymbol)==validTerminals.end())
+	      validTerminals.push_back(transition.iSymbol);
+	  std::sort(validTerminals.begin(),validTerminals.end());
 	  
-	  for(const size_t& iLookahead : iLookaheadsToInsert)
-	    for(const Lookahead& lookahead=lookaheads[iLookahead];const size_t& iPropagateToItem : lookahead.iPropagateToItems)
-	      {
-		const auto print=
-		  [this](const size_t &iItem)
-		  {
-		    std::string res;
-		    res+="item \""+describe(items[iItem])+"\" containing the following symbols:\n";
-		    for(size_t iS=0;iS<symbols.size();iS++)
-		      if(lookaheads[iItem].symbolIs.get(iS))
-			res+="  "+std::string(symbols[iS].name)+"\n";
-		    
-		    return res;
-		  };
-		
-		diagnostic(" Lookahead ",print(iLookahead)," inserting into ",print(iPropagateToItem));
-		
-		const size_t n=lookaheads[iPropagateToItem].symbolIs.insert(lookahead.symbolIs);
-		
-		if(n) nextLookaheads.push_back(iPropagateToItem);
-		
-		diagnostic("inserted ",n," into ",describe(items[iPropagateToItem]),"\n\n");
-	      }
+	  /// Matcher already associated to the same terminals, if any
+	  const auto ref=std::ranges::find(validTerminalsOfMatcher,validTerminals);
+	  
+	  iContextRegexMatcherOfState[iState]=std::distance(validTerminalsOfMatcher.begin(),ref);
 	  
-	  diagnostic("Next iteration\n");
+	  if(ref==validTerminalsOfMatcher.end())
+	    validTerminalsOfMatcher.push_back(std::move(validTerminals));
 	}
       
-      diagnostic("---\n");
-      for(size_t iItem=0;iItem<lookaheads.size();iItem++)
+      for(const std::vector<size_t>& validTerminals : validTerminalsOfMatcher)
 	{
-	  diagnostic("Item ",describe(items[iItem])," contains the following lookahead:\n");
-	  for(size_t iSymbol=0;iSymbol<symbols.size();iSymbol++)
-	    if(lookaheads[iItem].symbolIs.get(iSymbol))
-	      diagnostic("   ",symbols[iSymbol].name,"\n");
-	  diagnostic("---\n");
+	  /// Regexes of the matcher, and their symbols
+	  std::vector<std::string_view> regexes=whitespaceRegexList;
+	  std::vector<size_t> iSymbolOfContextRegex(regexes.size(),iWhitespaceSymbol);
+	  for(const size_t& iSymbol : validTerminals)
+	    {
+	      regexes.push_back(symbols[iSymbol].name);
+	      iSymbolOfContextRegex.push_back(iSymbol);
+	    }
+	  
+	  /// Matcher of the valid terminals, left without dStates if nothing is to be matched
+	  RegexMatcher& matcher=contextRegexMatchers.emplace_back();
+	  
+	  if(not regexes.empty())
+	    {
+	      matcher=createRegexMatcher(regexes);
+	      
+	      for(RegexMatcherDState& dState : matcher.dStates)
+		if(dState.accepting)
+		  dState.iToken=iSymbolOfContextRegex[dState.iToken];
+	    }
 	}
-    }
-    
-    /// Inserts a reduce transition
-    constexpr void insertReduceTransition(std::vector<GrammarTransition>& transitions,
-					  const size_t& iSymbol,
-					  const size_t& iProduction)
-    {
-      transitions.push_back(GrammarTransition::getReduce(iSymbol,iProduction));
-      diagnostic("        inserting new reduce transitions\n");
-    }
-    
-    /// Try to solve a shift/reduce conflict
-    constexpr void dealWithShiftReduceConflict(GrammarTransition& transition,
-					       const GrammarSymbol& symbol,
-					       const size_t& iProduction)
-    {
-      const GrammarProduction& production=productions[iProduction];
-      const size_t productionPrecedence=production.precedence(symbols);
       
-      if(productionPrecedence==0 or symbol.precedence==0 or
-	 (symbol.precedence==productionPrecedence and symbol.associativity==GrammarSymbol::Associativity::NONE))
-	errorEmitter((std::string("shift/reduce conflict for '")+std::string(symbols[production.iLhs].name)+"' on '"+std::string(symbol.name)+
-		      "' ought to transition: "+describe(transition)+"\nproduction precedence: "+std::to_string(productionPrecedence)+" symbol precedence: "+std::to_string(symbol.precedence)+" symbol associativity: "+std::to_string((int)symbol.associativity)).c_str());
-      else
-	if(productionPrecedence>symbol.precedence or (symbol.precedence==productionPrecedence and symbol.associativity==GrammarSymbol::Associativity::RIGHT))
-	  {
-	    diagnostic("overriding shift ",describe(transition));
-	    transition.type=GrammarTransition::REDUCE;
-	    transition.iStateOrProduction=iProduction;
-	    diagnostic(" into reduce: ",describe(transition));
-	  }
-	else
-	  {
-	    diagnostic("leaving already esisting transition ",describe(transition)," given that ");
-	    if(productionPrecedence<symbol.precedence)
-	      diagnostic(" the production has precedence ",productionPrecedence," lesser than the symbol ",symbol.precedence);
-	    else
-	      diagnostic(" the production has the same precedence ",productionPrecedence," of the symbol ,which has associatity",(int)symbol.associativity,
-			 " different from right (",(int)GrammarSymbol::Associativity::RIGHT);
-	  }
+      diagnostic("Generated ",contextRegexMatchers.size()," context regex matchers for ",stateTransitions.size()," states\n");
     }
     
-    /// Try to solve a reduce/reduce conflict
-    constexpr void dealWithReduceReduceConflict(GrammarTransition& transition,
-						const GrammarSymbol& symbol,
-						const size_t& iProduction)
+    /// Returns the action-less unit production reduced by the state regardless of the lookahead, if any
+    constexpr std::optional<size_t> iUnitReductionOfState(const size_t& iState) const
     {
-      const GrammarProduction& production=productions[iProduction];
-      const size_t productionPrecedence=production.precedence(symbols);
+      if(const std::optional<size_t>& iProduction=iDefaultReductionOfState[iState])
+	if(const GrammarProduction& production=productions[*iProduction];production.iRhsList.size()==1 and production.action.empty())
+	  if(std::all_of(stateTransitions[iState].begin(),stateTransitions[iState].end(),
+			 [&iProduction](const GrammarTransition& transition)
+			 {
+			   return transition.type==GrammarTransition::REDUCE and transition.iStateOrProduction==*iProduction;
+			 }))
+	    return iProduction;
       
-      if(const size_t& transitionPrecedence=productions[transition.iStateOrProduction].precedence(symbols);productionPrecedence==0 or transitionPrecedence==0 or
-	 productionPrecedence==transitionPrecedence)
-	errorEmitter((std::string("reduce/reduce conflict for '")+std::string(symbols[production.iLhs].name)+"' on '"+std::string(symbol.name)+
-		      "' ought to transition: "+describe(transition)+"\nproduction precedence: "+std::to_string(productionPrecedence)+" transition precedence: "+std::to_string(transitionPrecedence)).c_str());
-      else
-	if(productionPrecedence>transitionPrecedence)
-	  {
-	    diagnostic("overriding reduce: ",describe(transition));
-	    transition.iStateOrProduction=iProduction;
-	    diagnostic(" into reduce: ",describe(transition));
-	  }
-	else
-	  diagnostic("leaving already esisting transition ",describe(transition)," given that the production has precedence ",productionPrecedence," lesser than the transition ",transitionPrecedence);
+      return {};
     }
     
-    /// Generate reduce or shift transitions
-    constexpr void generateTransitions()
+    /// State reached from the state through the symbol, after following the chain of action-less unit reductions
+    ///
+    /// The states which can only reduce an action-less unit production
+    /// are bypassed, going straight to the goto state of the lhs
+    constexpr size_t bypassUnitReductions(const size_t& iState,
+					  const size_t& iSymbol) const
     {
-      diagnostic("-----------------------------------\n");
+      /// Symbol reached so far
+      size_t iReachedSymbol=iSymbol;
       
-      for(size_t iState=0;iState<stateItems.size();iState++)
+      /// State reached so far
+      size_t iReachedState=iState;
+      
+      /// Number of bypassed reductions, bounded to protect from cyclic unit productions
+      size_t nBypassed=0;
+      
+      do
 	{
-	  bool stateDescribed=0;
-	  GrammarState& state=stateItems[iState];
+	  /// Transitions of the state
+	  const std::vector<GrammarTransition>& transitions=stateTransitions[iState];
 	  
-	  for(size_t iIItem=0;iIItem<stateItems[iState].iItems.size();iIItem++)
-	    {
-	      bool itemDescribed=0;
-	      const size_t iItem=stateItems[iState].iItems[iIItem];
-	      const GrammarItem& item=items[iItem];
-	      const size_t& iProduction=item.iProduction;
-	      const GrammarProduction& production=productions[iProduction];
-	      
-	      if(item.position>=production.iRhsList.size())
-		for(size_t iSymbol=0;iSymbol<symbols.size();iSymbol++)
-		  {
-		    const GrammarSymbol& symbol=symbols[iSymbol];
-		    
-		    if(lookaheads[iItem].symbolIs.get(iSymbol))
-		      {
-			if(not stateDescribed)
-			  {
-			    diagnostic("State: \n",describe(state));
-			    stateDescribed=true;
-			  }
-			
-			if(not itemDescribed)
-			  {
-			    diagnostic("   in item ",describe(item),"\n     reduces:\n");
-			    itemDescribed=true;
-			  }
-			
-			diagnostic("      at symbol ",symbols[iSymbol].name,"\n");
-			
-			/// Position of the transition in the state
-			size_t iTransition=0;
-			std::vector<GrammarTransition>& transitions=stateTransitions[iState];
-			while(iTransition<transitions.size() and transitions[iTransition].iSymbol!=iSymbol)
-			  iTransition++;
-			
-			if(iTransition==transitions.size())
-			  insertReduceTransition(transitions,iSymbol,iProduction);
-			else
-			  {
-			    diagnostic("!!!!panic! state\n",describe(state)," has already transition:\n",describe(transitions[iTransition])," for symbol \'",symbol.name,"\'\n");
-			    
-			    if(GrammarTransition& transition=transitions[iTransition];transition.type==GrammarTransition::Type::SHIFT)
-			      dealWithShiftReduceConflict(transition,symbol,iProduction);
-			    else
-			      dealWithReduceReduceConflict(transition,symbol,iProduction);
-			  }
-		      }
-		  }
-	    }
+	  iReachedState=std::find_if(transitions.begin(),transitions.end(),
+				     [&iReachedSymbol](const GrammarTransition& transition)
+				     {
+				       return transition.type==GrammarTransition::SHIFT and transition.iSymbol==iReachedSymbol;
+				     })->iStateOrProduction;
+	  
+	  if(const std::optional<size_t> iProduction=iUnitReductionOfState(iReachedState))
+	    iReachedSymbol=productions[*iProduction].iLhs;
+	  else
+	    return iReachedState;
 	}
+      while(++nBypassed<stateTransitions.size());
+      
+      return iReachedState;
     }
     
-    /// Generate the regex matcher
-    constexpr void generateRegexMatcher()
+    /// Generate the compressed parse tables out of the transitions
+    ///
+    /// The targets of the shift transitions are redirected past the
+    /// chains of action-less unit reductions
+    constexpr void generateParseTables()
     {
-      /// List of regex paired to the token to be returned
-      std::vector<std::string_view> regexes;
-      
-      for(const std::string_view& w : whitespaceRegexList)
-	{
-	  regexes.emplace_back(w);
-	  iSymbolOfRegex.push_back(iWhitespaceSymbol);
-	}
+      diagnostic("-----------------------------------\n");
       
-      for(size_t iSymbol=0;iSymbol<symbols.size();iSymbol++)
-	if(symbols[iSymbol].type==GrammarSymbol::Type::TERMINAL_SYMBOL)
-	  {
-	    regexes.emplace_back(symbols[iSymbol].name);
-	    iSymbolOfRegex.push_back(iSymbol);
-	  }
+      /// Transitions with the unit reductions bypassed
+      std::vector<std::vector<GrammarTransition>> bypassedTransitions=stateTransitions;
       
-      diagnostic("List of TERMINAL and whitespaces regex recognized by the grammar, and corresponding token id:\n");
-      for(size_t iRegex=0;iRegex<regexes.size();iRegex++)
-	diagnostic("   ",regexes[iRegex]," -> ",iSymbolOfRegex[iRegex],"\n");
+      for(size_t iState=0;iState<stateTransitions.size();iState++)
+	for(GrammarTransition& transition : bypassedTransitions[iState])
+	  if(transition.type==GrammarTransition::SHIFT)
+	    if(const size_t iTarget=bypassUnitReductions(iState,transition.iSymbol);iTarget!=transition.iStateOrProduction)
+	      {
+		diagnostic("State ",iState," through symbol ",symbols[transition.iSymbol].name," bypasses unit reductions from state ",transition.iStateOrProduction," to state ",iTarget,"\n");
+		transition.iStateOrProduction=iTarget;
+	      }
       
-      regexMatcher=createRegexMatcher(regexes);
+      parseTables=GrammarParseTables(bypassedTransitions,iDefaultReductionOfState,symbols,productions.size());
+    }
+    
+    /// Lhs symbol of the production
+    constexpr size_t iLhsOfProduction(const size_t& iProduction) const
+    {
+      return productions[iProduction].iLhs;
+    }
+    
+    /// Number of rhs symbols of the production
+    constexpr size_t nRhsOfProduction(const size_t& iProduction) const
+    {
+      return productions[iProduction].iRhsList.size();
+    }
+    
+    /// Name of the action of the production, empty if none
+    constexpr std::string_view actionOfProduction(const size_t& iProduction) const
+    {
+      return productions[iProduction].action;
+    }
+    
+    /// Table holding an entry for each production
+    template <typename T>
+    constexpr std::vector<T> productionTable() const
+    {
+      return std::vector<T>(productions.size());
     }
     
-    constexpr Grammar(const std::string_view& str) :
-      currentPrecedence(0)
+    /// Builds the grammar out of its description
+    ///
+    /// When nThreads is larger than one and the grammar is not built
+    /// at compile time, the lexer is built concurrently to the parser
+    /// tables, and the most expensive phases of the latter are split
+    /// among the threads. The result is identical to the serial build
+    constexpr Grammar(const std::string_view& str,
+		      const size_t& nThreads=1) :
+      currentPrecedence(0),
+      nThreads(nThreads)
     {
       addGenericSymbols();
       parseTheGrammar(str);
       checkTheGrammar();
       grammarOptimize();
+      checkTheLexerModes();
       
-      calculateFirsts();
-      calculateFollows();
-      setPrecedence();
-      preComputeGotoStates();
-      generateStates();
+      /// Regexes of the lexer
+      const std::vector<std::string_view> regexes=listRegexes();
       
-      generateSpontaneousLookahead();
-      generateGotoItems();
-      propagateLookaheads();
-      generateTransitions();
+      const auto generateTables=
+	[this]()
+	{
+	  calculateNullables();
+	  calculateFirsts();
+	  calculateFollows();
+	  setPrecedence();
+	  preComputeClosures();
+	  generateStates();
+	  
+	  generateLookaheads();
+	  generateTransitions();
+	  generateParseTables();
+	};
       
-      generateRegexMatcher();
+      if(std::is_constant_evaluated() or nThreads<2)
+	{
+	  generateTables();
+	  generateRegexMatcher(regexes);
+	}
+      else
+	runConcurrently([this,&regexes]()
+	{
+	  generateRegexMatcher(regexes);
+	},generateTables);
     }
     
     /// Gets the parameters needed to build the constexpr grammar
@@ -3682,7 +7057,8 @@ namespace pp::internal
 	   .nRows=stateItems.size()},
 	 .stateTransitionsPars{.nEntries=vectorOfVectorsTotalEntries(stateTransitions),
 			       .nRows=stateTransitions.size()},
-	 .regexMachinePars=regexMatcher.getSizes()};
+	 .regexMachinePars=regexMatcher.getSizes(),
+	 .parseTablesPars=parseTables.getSizes()};
     }
   };
   
@@ -3697,6 +7073,9 @@ namespace pp::internal
     /// Index of the symbols representing a production, for each state
     Stack2DVector<size_t,Specs.productionPars> productionsData;
     
+    /// Name of the action of each production
+    std::array<std::string_view,Specs.productionPars.nRows> productionActions;
+    
     /// Items representing the states, defined in term of index of production and position
     std::array<GrammarItem,Specs.nItems> items;
     
@@ -3708,7 +7087,25 @@ namespace pp::internal
     /// applied (if reduce)
     Stack2DVector<GrammarTransition,Specs.stateTransitionsPars> stateTransitionsData;
     
-    RegexMatcherCt<Specs.regexMachinePars> regexParser;
+    /// Compressed tables of actions and goto states
+    GrammarParseTablesCt<Specs.parseTablesPars> parseTables;
+    
+    /// Start symbol
+    size_t iStartSymbol;
+    
+    /// Symbol marking the end of the input
+    size_t iEndSymbol;
+    
+    /// Symbol representing the whitespaces
+    size_t iWhitespaceSymbol;
+    
+    RegexMatcherCt<Specs.regexMachinePars> regexMatcher;
+    
+    /// Symbol of each structural character
+    StructuralSymbolOfChar iStructuralSymbolOfChar;
+    
+    /// Kind of string delimited by each character
+    StringDelimiterOfChar stringDelimiterOfChar;
     
     static_assert(Specs.stateTransitionsPars.nRows==Specs.stateItemsPars.nRows,"number of rows for stateTransitions and stateItems do not match");
     
@@ -3758,11 +7155,36 @@ namespace pp::internal
     };
     
     /// Returns a reference to a production
-    ProductionRef production(const size_t& iProduction) const
+    constexpr ProductionRef production(const size_t& iProduction) const
     {
       return {this,iProduction};
     }
     
+    /// Lhs symbol of the production
+    constexpr size_t iLhsOfProduction(const size_t& iProduction) const
+    {
+      return production(iProduction).iLhs();
+    }
+    
+    /// Number of rhs symbols of the production
+    constexpr size_t nRhsOfProduction(const size_t& iProduction) const
+    {
+      return production(iProduction).nRhs();
+    }
+    
+    /// Name of the action of the production, empty if none
+    constexpr std::string_view actionOfProduction(const size_t& iProduction) const
+    {
+      return productionActions[iProduction];
+    }
+    
+    /// Table holding an entry for each production
+    template <typename T>
+    constexpr std::array<T,Specs.productionPars.nRows> productionTable() const
+    {
+      return {};
+    }
+    
     /// Reference to an item
     struct ItemRef
     {
@@ -3895,6 +7317,9 @@ namespace pp::internal
 	return res;
       });
       
+      for(size_t iProduction=0;iProduction<Specs.productionPars.nRows;iProduction++)
+	productionActions[iProduction]=oth.productions[iProduction].action;
+      
       for(size_t iItem=0;iItem<Specs.nItems;iItem++)
 	this->items[iItem]=oth.items[iItem];
       
@@ -3902,16 +7327,27 @@ namespace pp::internal
       
       stateTransitionsData.fillWith([&oth](const size_t& iState)->const std::vector<GrammarTransition>&{return oth.stateTransitions[iState];});
       
-      regexParser=oth.regexMatcher;
+      parseTables=oth.parseTables;
+      
+      iStartSymbol=oth.iStartSymbol;
+      iEndSymbol=oth.iEndSymbol;
+      iWhitespaceSymbol=oth.iWhitespaceSymbol;
+      
+      regexMatcher=oth.regexMatcher;
+      iStructuralSymbolOfChar=oth.iStructuralSymbolOfChar;
+      stringDelimiterOfChar=oth.stringDelimiterOfChar;
     }
   };
   
   /// Create grammar from string
+  ///
+  /// The runtime grammar can be built using nThreads threads
   template <GrammarSpecs GS=GrammarSpecs{}>
-  constexpr auto createGrammar(const std::string_view& str)
+  constexpr auto createGrammar(const std::string_view& str,
+			       const size_t& nThreads=1)
   {
     /// Creates the grammar
-    Grammar grammar=str;
+    Grammar grammar(str,nThreads);
     
     if constexpr(GS.isNull())
       return grammar;
@@ -3934,6 +7370,152 @@ namespace pp::internal
     
     return createGrammar<GS>(str.str);
   }
+  
+  /////////////////////////////////////////////////////////////////
+  /////////////////////// Semantic actions ////////////////////////
+  /////////////////////////////////////////////////////////////////
+  
+  /// Callable bound to the name of the action of the productions
+  template <CtString Name,
+	    typename F>
+  struct SemanticAction
+  {
+    /// Name of the action, without the terminator
+    static constexpr std::string_view name{Name.str,Name.size()-1};
+    
+    /// Callable, taking the values of the rhs and returning the value of the lhs
+    F f;
+  };
+  
+  /// Binds the callable to the name of the action
+  ///
+  /// The name is only checked against the actions of the grammar by
+  /// bindActions. An action of the grammar left unbound is a compile
+  /// error only if bindActions is evaluated at compile time, as when
+  /// initializing a constexpr handler of a compile time grammar;
+  /// otherwise, and in particular for a runtime Grammar, the error is
+  /// issued through errorEmitter when the handler is created
+  template <CtString Name,
+	    typename F>
+  constexpr SemanticAction<Name,std::decay_t<F>> action(F&& f)
+  {
+    return {std::forward<F>(f)};
+  }
+  
+  /// Parse handler dispatching the reductions to the semantic actions
+  ///
+  /// The values of the terminal symbols are returned by the shift
+  /// callable given the matched string, and fix the type of all
+  /// values. Reductions are dispatched through a table of functions
+  /// indexed by the production, filled when binding the actions, so
+  /// that no name is compared while parsing. The productions without
+  /// action pass on the value of the first rhs symbol, if any
+  ///
+  /// The actions take the values of the rhs as a span of the single
+  /// Value type, rather than as arguments typed after each symbol:
+  /// the same handler must work with grammars built at runtime, whose
+  /// symbols are not known when the actions are compiled, and the
+  /// parser keeps the values in a single contiguous stack, whose
+  /// elements must all have the same type. Symbols carrying different
+  /// kinds of data can be handled choosing a std::variant as Value
+  template <typename G,
+	    typename Shift,
+	    typename...A>
+  struct SemanticActionsHandler
+  {
+    /// Type of the values associated to the symbols
+    using Value=std::remove_cvref_t<std::invoke_result_t<const Shift&,std::string_view>>;
+    
+    /// Function performing the reduction
+    using Reducer=Value(*)(const SemanticActionsHandler&,std::span<Value>);
+    
+    /// Callable computing the value of the terminal symbols
+    Shift shiftCallable;
+    
+    /// Semantic actions
+    std::tuple<A...> actions;
+    
+    /// Reduction function of each production
+    decltype(std::declval<const G&>().template productionTable<Reducer>()) reducerOfProduction;
+    
+    /// Reduces calling the I-th semantic action
+    template <size_t I>
+    static constexpr Value reduceWithAction(const SemanticActionsHandler& handler,
+					    std::span<Value> rhs)
+    {
+      return std::get<I>(handler.actions).f(rhs);
+    }
+    
+    /// Reduces passing on the value of the first rhs symbol
+    static constexpr Value reduceWithoutAction(const SemanticActionsHandler&,
+					       std::span<Value> rhs)
+    {
+      if(rhs.empty())
+	return {};
+      else
+	return std::move(rhs.front());
+    }
+    
+    /// Value of the terminal symbol
+    constexpr Value shift(const size_t& /* iSymbol */,
+			  const std::string_view& str) const
+    {
+      return shiftCallable(str);
+    }
+    
+    /// Value of the lhs of the production
+    constexpr Value reduce(const size_t& iProduction,
+			   std::span<Value> rhs) const
+    {
+      return reducerOfProduction[iProduction](*this,rhs);
+    }
+    
+    /// Binds the actions to the productions of the grammar
+    ///
+    /// Issues an error if the action of a production is not bound,
+    /// which is a compile error when binding at compile time
+    constexpr SemanticActionsHandler(const G& grammar,
+				     Shift shiftCallable,
+				     A...actions) :
+      shiftCallable(std::move(shiftCallable)),
+      actions(std::move(actions)...),
+      reducerOfProduction(grammar.template productionTable<Reducer>())
+    {
+      /// Names of the actions
+      constexpr std::array<std::string_view,sizeof...(A)> names{A::name...};
+      
+      /// Reduction function of each action
+      constexpr std::array<Reducer,sizeof...(A)> reducers=
+	[]<size_t...I>(std::index_sequence<I...>)
+	{
+	  return std::array<Reducer,sizeof...(A)>{&reduceWithAction<I>...};
+	}(std::index_sequence_for<A...>{});
+      
+      for(size_t iProduction=0;iProduction<reducerOfProduction.size();iProduction++)
+	if(const std::string_view action=grammar.actionOfProduction(iProduction);action.empty())
+	  reducerOfProduction[iProduction]=reduceWithoutAction;
+	else
+	  if(const auto it=std::find(names.begin(),names.end(),action);it==names.end())
+	    errorEmitter("Action of a production not bound to any callable");
+	  else
+	    reducerOfProduction[iProduction]=reducers[it-names.begin()];
+    }
+  };
+  
+  /// Binds the semantic actions to the productions of the grammar, returning the handler to be passed to parse
+  ///
+  /// A production whose action is not bound is a compile error when
+  /// the call is evaluated at compile time, and a runtime error
+  /// through errorEmitter otherwise
+  template <typename G,
+	    typename Shift,
+	    typename...A>
+  constexpr auto bindActions(const G& grammar,
+			     Shift&& shift,
+			     A&&...actions)
+  {
+    return SemanticActionsHandler<G,std::decay_t<Shift>,std::decay_t<A>...>(grammar,std::forward<Shift>(shift),std::forward<A>(actions)...);
+  }
 }
 
 namespace pp
@@ -3949,6 +7531,14 @@ namespace pp
   using pp::internal::Grammar;
   //using pp::internal::GrammarCt;
   using pp::internal::createGrammar;
+  
+  using pp::internal::action;
+  using pp::internal::bindActions;
+  using pp::internal::GrammarParseStacks;
+  using pp::internal::GrammarTree;
+  using pp::internal::GrammarParseStatus;
+  using pp::internal::GrammarParseEvent;
+  using pp::internal::GrammarStructuralIndex;
 }
 
 #endif
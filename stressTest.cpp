@@ -0,0 +1,154 @@
+#include <parsePact.hpp>
+
+using namespace pp;
+
+/// Grammar without lexer modes, built concurrently by all threads
+static constexpr char calcGrammar[]=
+  "calc {\
+    %whitespace \"[ \\t\\r\\n]*\";\
+    %left '\\+' '-';\
+    %left '\\*' '/';\
+    %none integer;\
+    stmts: stmts stmt | stmt;\
+    stmt: expr ';' [result];\
+    expr:\
+        expr '\\+' expr [add] |\
+        expr '-' expr [subtract] |\
+        expr '\\*' expr [multiply] |\
+        expr '/' expr [divide] |\
+        '\\(' expr '\\)' [compound] |\
+        integer [integer]\
+    ;\
+    integer: \"[0-9]+\";\
+}";
+
+/// Grammar with lexer modes, built concurrently by all threads
+static constexpr char stringsGrammar[]=
+  "strings {\
+    %whitespace \"[ ]+\";\
+    list: list item [add] | item [one];\
+    item: name [name] | '\"' \"[^\\\"]+\" '\"' [string] | '\"' '\"' [empty];\
+    name: \"[a-z]+\";\
+    %mode initial { '\"' -> string }\
+    %mode string { \"[^\\\"]+\" '\"' -> initial }\
+}";
+
+/// Determines whether the two grammars have the same automaton and parse tables
+bool sameAutomaton(const Grammar& first,
+		   const Grammar& second)
+{
+  /// Parse tables of the first grammar
+  const auto& f=first.parseTables;
+  
+  /// Parse tables of the second grammar
+  const auto& s=second.parseTables;
+  
+  return
+    first.stateItems==second.stateItems and
+    first.stateTransitions==second.stateTransitions and
+    first.iDefaultReductionOfState==second.iDefaultReductionOfState and
+    f.indexOfSymbol==s.indexOfSymbol and
+    f.actionBase==s.actionBase and
+    f.actionCheck==s.actionCheck and
+    f.actionEntries==s.actionEntries and
+    f.defaultActions==s.defaultActions and
+    f.lookaheadNeeded==s.lookaheadNeeded and
+    f.gotoBase==s.gotoBase and
+    f.gotoCheck==s.gotoCheck and
+    f.gotoEntries==s.gotoEntries and
+    f.defaultGoto==s.defaultGoto;
+}
+
+/// Builds the grammars serially and with several threads, returning the number of differing automata
+size_t buildSeriallyAndConcurrently()
+{
+  /// Number of differing automata
+  size_t nFailures=0;
+  
+  for(const char* grammar : {calcGrammar,stringsGrammar})
+    if(not sameAutomaton(Grammar(grammar,1),Grammar(grammar,4)))
+      nFailures++;
+  
+  return nFailures;
+}
+
+/// Converts the matched integer
+constexpr long toLong(const std::string_view& str)
+{
+  /// Converted value
+  long v=0;
+
+  for(const char& c : str)
+    v=v*10+c-'0';
+
+  return v;
+}
+
+/// Builds the grammar and a regex matcher and parses with them, returning the number of wrong results
+size_t buildAndParse(const size_t& iRound)
+{
+  /// Number of wrong results
+  size_t nFailures=0;
+
+  /// Grammar, built with an additional thread every other round
+  const Grammar grammar(calcGrammar,1+iRound%2);
+
+  /// Handler evaluating the expressions
+  const auto handler=
+    bindActions(grammar,toLong,
+		action<"add">([](const std::span<long>& rhs){return rhs[0]+rhs[2];}),
+		action<"subtract">([](const std::span<long>& rhs){return rhs[0]-rhs[2];}),
+		action<"multiply">([](const std::span<long>& rhs){return rhs[0]*rhs[2];}),
+		action<"divide">([](const std::span<long>& rhs){return rhs[0]/rhs[2];}),
+		action<"compound">([](const std::span<long>& rhs){return rhs[1];}),
+		action<"integer">([](const std::span<long>& rhs){return rhs[0];}),
+		action<"result">([](const std::span<long>& rhs){return rhs[0];}));
+
+  if(grammar.parse("1+2*(3-4);",handler)!=-1)
+    nFailures++;
+
+  if(grammar.parse("((12+3)*4)/5;",handler)!=12)
+    nFailures++;
+
+  if(grammar.parse("1+;",handler))
+    nFailures++;
+
+  /// Regex matcher
+  const RegexMatcher regexMatcher=
+    createRegexMatcher("[0-8]+","[a-z]+");
+
+  if(const auto res=regexMatcher.match("123abc");not res or res->iToken!=0 or res->matchedString!="123")
+    nFailures++;
+
+  return nFailures;
+}
+
+int main()
+{
+  /// Number of threads building concurrently
+  constexpr size_t nThreads=8;
+
+  /// Number of grammars built by each thread
+  constexpr size_t nRounds=4;
+
+  /// Number of wrong results
+  std::atomic<size_t> nFailures=0;
+
+  {
+    /// Threads building the grammars
+    std::vector<std::jthread> threads;
+
+    for(size_t iThread=0;iThread<nThreads;iThread++)
+      threads.emplace_back([&nFailures]()
+      {
+	for(size_t iRound=0;iRound<nRounds;iRound++)
+	  nFailures+=buildAndParse(iRound);
+	
+	nFailures+=buildSeriallyAndConcurrently();
+      });
+  }
+
+  fprintf(stderr,"%zu grammars built by %zu threads, %zu wrong results\n",nThreads*(nRounds+4),nThreads,nFailures.load());
+
+  return nFailures!=0;
+}
@@ -1,7 +1,16 @@
+#include <cassert>
+#include <string>
+
 #include <parsePact.hpp>
 
 using namespace pp;
 
+using pp::internal::BaseGrammarSymbol;
+using pp::internal::GrammarProduction;
+using pp::internal::diagnostic;
+using pp::internal::errorEmitter;
+using pp::internal::estimateGrammarSize;
+
 constexpr void test()
 {
   //parseTreeFromRegex("(\\+|\\-)?[0-9]+","(\\+|\\-)?[0-9]+(\\.[0-9]+)?((e|E)(\\+|\\-)?[0-9]+)?","[^h]");
@@ -22,15 +31,12 @@ constexpr void test()
   
   /////////////////////////////////////////////////////////////////
   
-  /// Storage properties of the regex pattern matcher
-  constexpr auto specs=estimateRegexParserSize(jsonNumberPattern,jsonRealNumberPattern,testNotContainingHPattern);
-  
   /// Regex parser matcher
-  constexpr auto parser=createParserFromRegex<specs>(jsonNumberPattern,jsonRealNumberPattern,testNotContainingHPattern);
+  constexpr auto parser=createRegexMatcher<jsonNumberPattern,jsonRealNumberPattern,testNotContainingHPattern>();
   
-  static_assert(parser.parse("-332.235e-34")->iToken==JSON_REAL_NUMER);
-  static_assert(parser.parse("33")->iToken==JSON_NUMBER);
-  static_assert(parser.parse("ello world!")->iToken==TEXT_NOT_CONTAINING_H);
+  static_assert(parser.match("-332.235e-34")->iToken==JSON_REAL_NUMER);
+  static_assert(parser.match("33")->iToken==JSON_NUMBER);
+  static_assert(parser.match("ello world!")->iToken==TEXT_NOT_CONTAINING_H);
   
   // if(constexpr auto u=parser.parse("-332.235e-34"))
   //   printf("tok %zu\n",*u);
@@ -40,9 +46,598 @@ constexpr void test()
   //  static_assert(parser.parse("3")==0);
 }
 
+/// Calculator grammar, used to check the parsing entry points against each other
+static constexpr char calcGrammar[]=
+  "calc {\
+    %whitespace \"[ \\t\\r\\n]*\";\
+    %left '\\+' '-';\
+    %left '\\*' '/';\
+    %none integer;\
+    stmts: stmts stmt | stmt;\
+    stmt: expr ';' [result];\
+    expr:\
+        expr '\\+' expr [add] |\
+        expr '-' expr [subtract] |\
+        expr '\\*' expr [multiply] |\
+        expr '/' expr [divide] |\
+        '\\(' expr '\\)' [compound] |\
+        integer [integer]\
+    ;\
+    integer: \"[0-9]+\";\
+}";
+
+/// Grammar lexing the content of the strings in a lexer mode of its own
+static constexpr char stringsGrammar[]=
+  "strings {\
+    %whitespace \"[ ]+\";\
+    list: list item [add] | item [one];\
+    item: name [name] | '\"' \"[^\\\"]+\" '\"' [string] | '\"' '\"' [empty];\
+    name: \"[a-z]+\";\
+    %mode initial { '\"' -> string }\
+    %mode string { \"[^\\\"]+\" '\"' -> initial }\
+}";
+
+/// Grammar whose strings can contain the structural characters and escaped quotes
+static constexpr char jsonLikeGrammar[]=
+  "jsonLike {\
+    %whitespace \"[ \\t\\r\\n]*\";\
+    value: '\\{' members '\\}' [object] | '\\{' '\\}' [empty] | '\\[' elements '\\]' [array] | string [string] | number [number] | 'true' [true];\
+    members: members ',' member [add_member] | member [first_member];\
+    member: string ':' value [member];\
+    elements: elements ',' value [add_element] | value [first_element];\
+    string: \"\\\"([^\\\"\\\\]|\\\\.)*\\\"\";\
+    number: \"[0-8]+\";\
+}";
+
+/// Input of the jsonLike grammar, with strings containing structural characters, escaped quotes and backslashes
+static constexpr std::string_view jsonLikeInput=
+  "[{\"k,[\": \"v\\\"}\", \"n\": 12}, \"str, with] chars\", [1, 2, true], \"a\\\\\", {}, \"{\\\"x\\\":[1]}\","
+  " {\"\": [\"\\\\\", \"\\\",\"]}, \"\\\\\\\"]\", 345]";
+
+/// Grammar in which the separator of the arrays also separates the items of the tuples
+static constexpr char tuplesGrammar[]=
+  "tuples {\
+    %whitespace \"[ ]*\";\
+    value: '\\[' elements '\\]' [array] | '\\(' tuple '\\)' [tuple] | number [number];\
+    elements: elements ',' value [add_element] | value [first_element];\
+    tuple: tuple ',' value [add_item] | value [first_item];\
+    number: \"[0-8]+\";\
+}";
+
+/// Converts the matched integer
+constexpr long toLong(const std::string_view& str)
+{
+  /// Converted value
+  long v=0;
+  
+  for(const char& c : str)
+    v=v*10+c-'0';
+  
+  return v;
+}
+
+/// Binds the actions of the calculator grammar
+constexpr auto bindCalculator(const auto& grammar)
+{
+  return
+    bindActions(grammar,toLong,
+		action<"add">([](const std::span<long>& rhs){return rhs[0]+rhs[2];}),
+		action<"subtract">([](const std::span<long>& rhs){return rhs[0]-rhs[2];}),
+		action<"multiply">([](const std::span<long>& rhs){return rhs[0]*rhs[2];}),
+		action<"divide">([](const std::span<long>& rhs){return rhs[0]/rhs[2];}),
+		action<"compound">([](const std::span<long>& rhs){return rhs[1];}),
+		action<"integer">([](const std::span<long>& rhs){return rhs[0];}),
+		action<"result">([](const std::span<long>& rhs){return rhs[0];}));
+}
+
+/// Handler evaluating the calculator grammar by looking at the name of the actions
+struct Calculator
+{
+  /// Grammar being parsed
+  const Grammar& g;
+  
+  /// Value associated to each symbol
+  using Value=long;
+  
+  /// Converts the shifted integer
+  Value shift(const size_t& /* iSymbol */,
+	      const std::string_view& matchedString)
+  {
+    return toLong(matchedString);
+  }
+  
+  /// Evaluates the reduced production
+  Value reduce(const size_t& iProduction,
+	       const std::span<Value>& rhs)
+  {
+    /// Name of the action
+    const std::string_view action=g.productions[iProduction].action;
+    
+    if(action=="add")
+      return rhs[0]+rhs[2];
+    else if(action=="subtract")
+      return rhs[0]-rhs[2];
+    else if(action=="multiply")
+      return rhs[0]*rhs[2];
+    else if(action=="divide")
+      return rhs[0]/rhs[2];
+    else if(action=="compound")
+      return rhs[1];
+    else
+      return rhs.empty()?0:rhs[0];
+  }
+};
+
+/// Handler counting the shifts and the reductions
+struct Counter
+{
+  /// Number of shifts and reductions needed to build the symbol
+  using Value=size_t;
+  
+  /// Counts the shift
+  constexpr Value shift(const size_t& /* iSymbol */,
+			const std::string_view& /* matchedString */)
+  {
+    return 1;
+  }
+  
+  /// Counts the reduction and those of the rhs
+  constexpr Value reduce(const size_t& /* iProduction */,
+			 const std::span<Value>& rhs)
+  {
+    /// Result
+    Value n=1;
+    
+    for(const Value& r : rhs)
+      n+=r;
+    
+    return n;
+  }
+};
+
+/// Handler collecting the shifted strings, so that wrongly split tokens are noticed
+struct Lexemes
+{
+  /// Shifted strings, each followed by a separator
+  using Value=std::string;
+  
+  /// Copies the shifted string
+  Value shift(const size_t& /* iSymbol */,
+	      const std::string_view& matchedString)
+  {
+    return std::string(matchedString)+"|";
+  }
+  
+  /// Concatenates the strings of the rhs
+  Value reduce(const size_t& /* iProduction */,
+	       const std::span<Value>& rhs)
+  {
+    /// Result
+    Value res;
+    
+    for(const Value& r : rhs)
+      res+=r;
+    
+    return res;
+  }
+};
+
+/// Listener counting the shifts and the reductions
+struct EventsCounter
+{
+  /// Number of events
+  size_t n{};
+  
+  /// Counts the shift
+  void onShift(const size_t& /* iSymbol */,
+	       const std::string_view& /* matchedString */)
+  {
+    n++;
+  }
+  
+  /// Counts the reduction
+  void onReduce(const size_t& /* iProduction */,
+		const std::string_view& /* matchedString */)
+  {
+    n++;
+  }
+};
+
+/// Source providing the input to the asynchronous parser one chunk at a time, without ever suspending
+struct ChunksSource
+{
+  /// Chunks of the input
+  std::vector<std::string_view> chunks;
+  
+  /// Next chunk to be provided
+  size_t iChunk{};
+  
+  /// Awaitable returning the next chunk, immediately ready
+  struct NextChunk
+  {
+    /// Source
+    ChunksSource& source;
+    
+    /// The chunk is always available
+    bool await_ready() const
+    {
+      return true;
+    }
+    
+    /// Never called
+    void await_suspend(std::coroutine_handle<>)
+    {
+    }
+    
+    /// Returns the chunk, or an empty one when the input is over
+    std::string_view await_resume()
+    {
+      if(source.iChunk<source.chunks.size())
+	return source.chunks[source.iChunk++];
+      else
+	return {};
+    }
+  };
+  
+  /// Returns the awaitable providing the next chunk
+  NextChunk next()
+  {
+    return {*this};
+  }
+};
+
+/// Coroutine consuming the events of the asynchronous parser
+struct EventsConsumer
+{
+  /// Runs the coroutine eagerly and to completion
+  struct promise_type
+  {
+    EventsConsumer get_return_object()
+    {
+      return {};
+    }
+    
+    std::suspend_never initial_suspend()
+    {
+      return {};
+    }
+    
+    std::suspend_never final_suspend() noexcept
+    {
+      return {};
+    }
+    
+    void return_void()
+    {
+    }
+    
+    void unhandled_exception()
+    {
+      std::terminate();
+    }
+  };
+};
+
+/// Counts the shifts and reductions yielded by the asynchronous parser, setting whether the input has been accepted
+EventsConsumer countAsyncEvents(const Grammar& grammar,
+				ChunksSource& source,
+				size_t& n,
+				bool& accepted)
+{
+  /// Generator of the events
+  auto events=grammar.parseAsync(source);
+  
+  while(const std::optional<GrammarParseEvent> event=co_await events.next())
+    if(event->type==GrammarParseEvent::SHIFT or event->type==GrammarParseEvent::REDUCE)
+      n++;
+    else
+      accepted=(event->type==GrammarParseEvent::ACCEPT);
+}
+
+/// Compile time grammar
+constexpr auto ctCalc=createGrammar<calcGrammar>();
+
+static_assert(*ctCalc.parse("1+2*(3-4);",bindCalculator(ctCalc))==-1);
+
+/// Input of the calculator grammar
+static constexpr std::string_view calcInput=
+  "1+2*(3-4); (12+3)*(4/2); 87-(6*5);";
+
+/// Checks the plain parse, with the actions bound by name and looked up by the handler
+void checkParse()
+{
+  /// Grammar to be parsed
+  const Grammar calc(calcGrammar);
+  
+  /// Result with the bound actions
+  const std::optional<long> bound=calc.parse(calcInput,bindCalculator(calc));
+  
+  /// Result of the handler looking up the actions by name
+  const std::optional<long> byName=calc.parse(calcInput,Calculator{calc});
+  
+  assert(bound.has_value() and *bound==-1);
+  assert(byName.has_value() and *byName==*bound);
+  assert(not calc.parse("1+;",bindCalculator(calc)));
+}
+
+/// Checks that recognizing agrees with the plain parse
+void checkRecognizes()
+{
+  /// Grammar to be parsed
+  const Grammar calc(calcGrammar);
+  
+  assert(calc.recognizes(calcInput) and not calc.recognizes("1+;"));
+}
+
+/// Checks that the listener receives all the shifts and reductions of the plain parse
+void checkParseEvents()
+{
+  /// Grammar to be parsed
+  const Grammar calc(calcGrammar);
+  
+  /// Number of shifts and reductions of the plain parse
+  const std::optional<size_t> nRef=calc.parse(calcInput,Counter{});
+  
+  /// Listener of the shifts and reductions
+  EventsCounter eventsCounter;
+  
+  assert(nRef.has_value());
+  assert(calc.parseEvents(calcInput,eventsCounter) and eventsCounter.n==*nRef);
+}
+
+/// Checks that the tree has a node for each shift and reduction of the plain parse
+void checkParseTree()
+{
+  /// Grammar to be parsed
+  const Grammar calc(calcGrammar);
+  
+  /// Number of shifts and reductions of the plain parse
+  const std::optional<size_t> nRef=calc.parse(calcInput,Counter{});
+  
+  /// Concrete syntax tree
+  GrammarTree tree;
+  
+  /// Root of the tree
+  const std::optional<size_t> iRoot=calc.parseTree(calcInput,tree);
+  
+  assert(nRef.has_value() and iRoot.has_value());
+  assert(*iRoot==tree.nodes.size()-1 and tree.nodes.size()==*nRef and tree.nodes[*iRoot].str==calcInput);
+}
+
+/// Checks the push parser against the plain parse, with all the chunk sizes
+void checkPushParser()
+{
+  for(const char* grammarString : {calcGrammar,jsonLikeGrammar})
+    {
+      /// Grammar to be parsed
+      const Grammar grammar(grammarString);
+      
+      /// Input to be parsed
+      const std::string_view input=
+	(grammarString==calcGrammar)?calcInput:jsonLikeInput;
+      
+      /// Result of the plain parse
+      const std::optional<std::string> ref=grammar.parse(input,Lexemes{});
+      
+      assert(ref.has_value());
+      
+      for(size_t chunkSize=1;chunkSize<=input.size();chunkSize++)
+	{
+	  /// Parser fed one chunk at a time
+	  auto pushParser=grammar.pushParser(Lexemes{});
+	  
+	  for(size_t i=0;i<input.size();i+=chunkSize)
+	    pushParser.push(input.substr(i,chunkSize));
+	  
+	  assert(pushParser.finish()==GrammarParseStatus::ACCEPT and pushParser.result()==*ref);
+	}
+    }
+}
+
+/// Checks that the asynchronous parser yields all the shifts and reductions of the plain parse
+void checkParseAsync()
+{
+  /// Grammar to be parsed
+  const Grammar calc(calcGrammar);
+  
+  /// Number of shifts and reductions of the plain parse
+  const std::optional<size_t> nRef=calc.parse(calcInput,Counter{});
+  
+  /// Source of the asynchronous parser
+  ChunksSource source{{calcInput.substr(0,11),calcInput.substr(11,5),calcInput.substr(16)}};
+  
+  /// Number of shifts and reductions of the asynchronous parser
+  size_t nAsync=0;
+  
+  /// Result of the asynchronous parser
+  bool asyncAccepted=false;
+  
+  countAsyncEvents(calc,source,nAsync,asyncAccepted);
+  
+  assert(nRef.has_value());
+  assert(asyncAccepted and nAsync==*nRef);
+}
+
+/// Checks that the batch gives the result of the plain parse of each input, with one and more threads
+void checkParseBatch()
+{
+  /// Grammar to be parsed
+  const Grammar calc(calcGrammar);
+  
+  /// Handler evaluating the expressions
+  const auto calculator=bindCalculator(calc);
+  
+  /// Inputs parsed in batch
+  const std::vector<std::string_view> inputs{"1+2;",calcInput,"3*;","(4);"};
+  
+  for(size_t nThreads=1;nThreads<=3;nThreads+=2)
+    {
+      /// Results of the batch
+      std::vector<std::optional<long>> outputs(inputs.size());
+      
+      calc.parseBatch(inputs,outputs,calculator,nThreads);
+      
+      for(size_t iInput=0;iInput<inputs.size();iInput++)
+	if(const std::optional<long> single=calc.parse(inputs[iInput],calculator);inputs[iInput]=="3*;")
+	  assert(not single.has_value() and not outputs[iInput].has_value());
+	else
+	  assert(single.has_value() and outputs[iInput].has_value() and *outputs[iInput]==*single);
+    }
+}
+
+/// Checks the parallel parse against the plain parse, splitting at terminals which can also appear inside strings, and that the flat lists are stitched without fallbacks
+void checkParseParallel()
+{
+  for(const auto& [grammarString,input,syncSymbol] : {std::make_tuple(calcGrammar,calcInput,";"),{jsonLikeGrammar,jsonLikeInput,","}})
+    {
+      /// Grammar to be parsed
+      const Grammar grammar(grammarString);
+      
+      /// Result of the plain parse
+      const std::optional<std::string> ref=grammar.parse(input,Lexemes{});
+      
+      assert(ref.has_value());
+      
+      for(size_t nThreads=2;nThreads<=5;nThreads++)
+	{
+	  /// Result of the parallel parse
+	  const std::optional<std::string> res=grammar.parseParallel(input,Lexemes{},syncSymbol,nThreads);
+	  
+	  assert(res.has_value() and *res==*ref);
+	}
+    }
+  
+  /// Flat array, the elements of which are all parsed from the state reached shifting the separator
+  std::string array="[";
+  for(size_t i=0;i<200;i++)
+    array+=(i%2)?"\"s, \\\"t\", ":"1234, ";
+  array+="true]";
+  
+  /// Flat tuple, the items of which can be parsed also from the state reached shifting the separator of the arrays
+  std::string tuple="(";
+  for(size_t i=0;i<200;i++)
+    tuple+="12, ";
+  tuple+="3)";
+  
+  for(const auto& [grammarString,input] : {std::make_pair(jsonLikeGrammar,std::string_view(array)),{tuplesGrammar,tuple}})
+    {
+      /// Grammar to be parsed
+      const Grammar grammar(grammarString);
+      
+      /// Result of the plain parse
+      const std::optional<std::string> ref=grammar.parse(input,Lexemes{});
+      
+      assert(ref.has_value());
+      
+      for(size_t nThreads=2;nThreads<=5;nThreads++)
+	{
+	  /// Number of pieces not stitched
+	  size_t nFallbacks;
+	  
+	  /// Result of the parallel parse
+	  const std::optional<std::string> res=grammar.parseParallel(input,Lexemes{},",",nThreads,nFallbacks);
+	  
+	  assert(res.has_value() and *res==*ref and nFallbacks==0);
+	}
+    }
+}
+
+/// Checks that the pipelined parse gives the result of the plain parse
+void checkParsePipelined()
+{
+  /// Grammar to be parsed
+  const Grammar calc(calcGrammar);
+  
+  /// Result of the plain parse
+  const std::optional<long> ref=calc.parse(calcInput,bindCalculator(calc));
+  
+  /// Result of the pipelined parse
+  const std::optional<long> res=calc.parsePipelined(calcInput,bindCalculator(calc));
+  
+  assert(ref.has_value() and res.has_value() and *res==*ref);
+}
+
+/// Checks that the indexed parse gives the result of the plain parse, also skipping the structural characters inside the strings
+void checkParseIndexed()
+{
+  for(const char* grammarString : {calcGrammar,jsonLikeGrammar})
+    {
+      /// Grammar to be parsed
+      const Grammar grammar(grammarString);
+      
+      /// Input to be parsed
+      const std::string_view input=
+	(grammarString==calcGrammar)?calcInput:jsonLikeInput;
+      
+      /// Result of the plain parse
+      const std::optional<std::string> ref=grammar.parse(input,Lexemes{});
+      
+      /// Result of the indexed parse
+      const std::optional<std::string> res=grammar.parseIndexed(input,Lexemes{});
+      
+      assert(ref.has_value() and res.has_value() and *res==*ref);
+    }
+  
+  /// Grammar with strings
+  const Grammar jsonLike(jsonLikeGrammar);
+  
+  assert(jsonLike.stringDelimiterOfChar['"']==pp::internal::StringDelimiter::WITH_ESCAPES);
+  
+  for(const char& c : std::string_view(",:[]{}"))
+    assert(jsonLike.iStructuralSymbolOfChar[(unsigned char)c]!=pp::internal::noStructuralSymbol);
+}
+
+/// Checks that the parse with context regex matchers gives the result of the plain parse
+void checkParseContextual()
+{
+  /// Grammar to be parsed
+  Grammar calc(calcGrammar);
+  
+  calc.generateContextRegexMatchers();
+  
+  /// Result of the plain parse
+  const std::optional<long> ref=calc.parse(calcInput,bindCalculator(calc));
+  
+  /// Result of the contextual parse
+  const std::optional<long> res=calc.parseContextual(calcInput,bindCalculator(calc));
+  
+  assert(ref.has_value() and res.has_value() and *res==*ref);
+}
+
+/// Checks that the parse with modes agrees with the plain parse, and lexes what the latter cannot
+void checkParseWithModes()
+{
+  /// Grammar with lexer modes
+  const Grammar strings(stringsGrammar);
+  
+  /// Result of the parse with modes
+  const std::optional<size_t> withModes=strings.parseWithModes("ab cd",Counter{});
+  
+  /// Result of the plain parse
+  const std::optional<size_t> withoutModes=strings.parse("ab cd",Counter{});
+  
+  assert(withModes.has_value() and withoutModes.has_value() and *withModes==*withoutModes);
+  
+  assert(strings.parseWithModes("ab \"x y, z\" cd \"\"",Counter{}) and not strings.parse("ab \"x y, z\" cd \"\"",Counter{}));
+}
+
 int main(int narg,char** arg)
 {
   test();
+  
+  checkParse();
+  checkRecognizes();
+  checkParseEvents();
+  checkParseTree();
+  checkPushParser();
+  checkParseAsync();
+  checkParseBatch();
+  checkParseParallel();
+  checkParsePipelined();
+  checkParseIndexed();
+  checkParseContextual();
+  checkParseWithModes();
+  
   // Matching m("/* *ciao  d* \n mondo */    // come va \n qui { %left bene");
   
   static constexpr char jsonGrammar[]=
@@ -88,10 +683,20 @@ int main(int narg,char** arg)
   
   //Grammar grammar(jsonGrammar);
   auto c=createGrammar(xmlGrammar);
-  constexpr auto c2=createConstexprGrammar([]() constexpr{return xmlGrammar;});
   
-  constexpr size_t c2Size=sizeof(c2.regexParser);
-  static_assert(c2Size==1,"");
+  static constexpr char xmlExample[]=
+    "<?xml version=\":string: ?>\n"
+    "<catalog>\n"
+    "  <book id=\":string:>\n"
+    "    <title/>\n"
+    "    <author/>\n"
+    "  </book>\n"
+    "  <book/>\n"
+    "</catalog>\n";
+  
+  constexpr auto c2=createGrammar<xmlGrammar>();
+  
+  static_assert(c2.recognizes(xmlExample),"");
   
   diagnostic("Productions (dynamic instantiation):\n");
   diagnostic("------------\n");
@@ -133,106 +738,39 @@ int main(int narg,char** arg)
   diagnostic("nTransitions: ",specs.regexMachinePars.nTransitions,"\n");
   diagnostic("\n");
 
-
-  constexpr char xmlExample[]=
-#include "xmlExample.xml"
-	      ;
-  
-  std::string_view x=xmlExample;
-  bool m;
-  size_t i=0;
-  std::vector<size_t> states{0};
-  std::vector<size_t> symbols{0};
-  size_t cursor=1;
   
-  diagnostic("nStates: ",states.size(),"\n");
-  
-  do
+  /// Handler printing the shifts and reductions of the parser
+  struct Printer
+  {
+    /// Grammar being parsed
+    const Grammar& g;
+    
+    /// Value associated to each symbol, which is just its index
+    using Value=size_t;
+    
+    /// Prints the shifted symbol
+    Value shift(const size_t& iSymbol,
+		const std::string_view& matchedString)
     {
-      const size_t iState=states.back();
+      diagnostic("shifting \"",matchedString,"\" as symbol ",iSymbol," \"",g.symbols[iSymbol].name,"\"\n");
       
-      diagnostic("/////////////////////////////////////////////////////////////////\n");
-      
-      diagnostic("At state: ",iState,"\n");
-      diagnostic(c.describe(c.stateItems[iState]));
-      for(const GrammarTransition& t : c.stateTransitions[iState])
-	diagnostic(c.describe(t));
-      
-      size_t nextToken=0;
-      
-      if(cursor<symbols.size())
-	{
-	  nextToken=symbols[cursor];
-	  diagnostic("No need to parse, nextToken from cursor: ",nextToken,"\n");
-	}
-      else
-	{
-	  diagnostic("Parsed ",i," tokens, going to parse: ",x,"\n");
-	  
-	  auto r=c.regexParser.parse(x);
-	  m=r.has_value();
-	  
-	  if(r)
-	    {
-	      x={x.begin()+r->str.length(),x.end()};
-	      nextToken=r->iToken;
-	      if(nextToken!=c.iWhitespaceSymbol)
-		symbols.emplace(symbols.begin()+cursor,nextToken);
-	      
-	      diagnostic("matched string: \"",r->str,"\" corresponding to token ",r->iToken," \"",c.symbols[r->iToken].name,"\"\n");
-	      i++;
-	    }
-	  else
-	    diagnostic("unable to parse \"",x,"\"\n");
-	}
+      return iSymbol;
+    }
+    
+    /// Prints the reduced production
+    Value reduce(const size_t& iProduction,
+		 const std::span<Value>& rhs)
+    {
+      diagnostic("reducing ",rhs.size()," symbols with production: ",g.describe(g.productions[iProduction]),"\n");
       
-      diagnostic("mmmm: ",m,"\n");
-      if(m and nextToken!=c.iWhitespaceSymbol)
-	{
-	  const std::vector<GrammarTransition>& transitions=c.stateTransitions[iState];
-	  
-	  size_t iTransition=0;
-	  while(iTransition<transitions.size() and transitions[iTransition].iSymbol!=nextToken)
-	    iTransition++;
-	  
-	  if(iTransition<transitions.size())
-	    {
-	      const GrammarTransition& t=transitions[iTransition];
-	      
-	      diagnostic("Going to use transition: ",c.describe(t),"\n");
-	      if(t.type==GrammarTransition::Type::REDUCE)
-		{
-		  const GrammarProduction& production=c.productions[t.iStateOrProduction];
-		  //states.pop_back();
-		  symbols.erase(symbols.begin()+cursor-production.iRhsList.size(),symbols.begin()+cursor);
-		  cursor-=production.iRhsList.size();
-		  symbols.emplace(symbols.begin()+cursor,production.iLhs);
-		}
-	      else
-		{
-		  states.push_back(t.iStateOrProduction);
-		  cursor++;
-		}
-	      
-	      diagnostic("States:\n");
-	      for(const size_t& iState : states)
-		diagnostic("   ",iState,"\n");
-	      
-	      diagnostic("Symbols:\n");
-	      for(size_t iiSymbol=0;iiSymbol<symbols.size();iiSymbol++)
-		{
-		  const size_t iSymbol=symbols[iiSymbol];
-		  
-		  diagnostic("   ",iSymbol," ",c.symbols[iSymbol].name,"\n");
-		  if(cursor==iiSymbol)
-		    diagnostic(".......\n");
-		}
-	    }
-	  else
-	    errorEmitter("Unable to find transition");
-	}
+      return g.productions[iProduction].iLhs;
     }
-  while(m and x.length());
+  };
+  
+  if(c.parse(xmlExample,Printer{c}))
+    diagnostic("parsed\n");
+  else
+    errorEmitter("Unable to parse");
   
   // diagnostic("/////////////////////////////////////////////////////////////////\n");
   // auto par=createParserFromRegex("<",">","<\\?xml","\\?>","/>","</","=","[A-Za-z_:][A-Za-z0-9_:\\.-]*");